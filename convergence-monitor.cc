@@ -0,0 +1,167 @@
+#include "convergence-monitor.h"
+
+#include <cmath>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("ConvergenceMonitor");
+
+// Two-sided 97.5% Student-t quantile; normal approximation past 30 dof.
+static double
+StudentT975(uint32_t dof)
+{
+    static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+                                   2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+                                   2.110,  2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+                                   2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+    if (dof == 0)
+        return 0.0;
+    if (dof <= 30)
+        return table[dof - 1];
+    return 1.96;
+}
+
+uint32_t
+MserTruncation(const std::vector<double>& x)
+{
+    uint32_t n = x.size();
+    if (n < 4)
+        return 0;
+
+    // Suffix sums let every candidate d be scored in O(1).
+    std::vector<double> sum(n + 1, 0.0), sumSq(n + 1, 0.0);
+    for (uint32_t i = n; i-- > 0;)
+    {
+        sum[i] = sum[i + 1] + x[i];
+        sumSq[i] = sumSq[i + 1] + x[i] * x[i];
+    }
+
+    uint32_t best = 0;
+    double bestScore = INFINITY;
+    for (uint32_t d = 0; d <= n / 2; ++d)
+    {
+        double m = n - d;
+        double sse = sumSq[d] - sum[d] * sum[d] / m;
+        double score = sse / (m * m);
+        if (score < bestScore)
+        {
+            bestScore = score;
+            best = d;
+        }
+    }
+    return best;
+}
+
+void
+BatchMeansInterval(const std::vector<double>& x, uint32_t from, double& mean, double& hw)
+{
+    mean = 0.0;
+    hw = INFINITY;
+    if (from >= x.size())
+        return;
+    uint32_t k = x.size() - from;
+    for (uint32_t i = from; i < x.size(); ++i)
+        mean += x[i];
+    mean /= k;
+    if (k < 2)
+        return;
+    double var = 0.0;
+    for (uint32_t i = from; i < x.size(); ++i)
+        var += (x[i] - mean) * (x[i] - mean);
+    var /= (k - 1);
+    hw = StudentT975(k - 1) * std::sqrt(var / k);
+}
+
+ConvergenceMonitor::ConvergenceMonitor(Ptr<FlowMonitor> monitor, const Params& params)
+    : m_monitor(monitor),
+      m_params(params)
+{
+}
+
+void
+ConvergenceMonitor::Start(Time at)
+{
+    Simulator::Schedule(at, &ConvergenceMonitor::Sample, this);
+}
+
+void
+ConvergenceMonitor::Sample()
+{
+    uint64_t rxBytes = 0;
+    uint64_t rxPackets = 0;
+    double delaySum = 0.0;
+    for (auto& kv : m_monitor->GetFlowStats())
+    {
+        rxBytes += kv.second.rxBytes;
+        rxPackets += kv.second.rxPackets;
+        delaySum += kv.second.delaySum.GetSeconds();
+    }
+
+    // The first call only records the baseline counters.
+    if (m_primed)
+    {
+        m_throughput.push_back((rxBytes - m_lastRxBytes) * 8.0 / (m_params.interval * 1e6));
+        uint64_t dPkts = rxPackets - m_lastRxPackets;
+        if (dPkts > 0)
+            m_delay.push_back((delaySum - m_lastDelaySum) / dPkts * 1000.0);
+    }
+    m_primed = true;
+    m_lastRxBytes = rxBytes;
+    m_lastRxPackets = rxPackets;
+    m_lastDelaySum = delaySum;
+
+    if (CheckConvergence())
+    {
+        m_converged = true;
+        NS_LOG_UNCOND("[AUTOSTOP] Converged at t=" << Simulator::Now().GetSeconds() << "s after "
+                                                   << m_throughput.size() << " batches (truncated "
+                                                   << m_truncated << "): throughput "
+                                                   << m_tputMean << " ± " << m_tputHw
+                                                   << " Mbps, delay " << m_delayMean << " ± "
+                                                   << m_delayHw << " ms");
+        Simulator::Stop();
+        return;
+    }
+
+    Time next = Simulator::Now() + Seconds(m_params.interval);
+    if (next.GetSeconds() <= m_params.maxTime)
+    {
+        Simulator::Schedule(Seconds(m_params.interval), &ConvergenceMonitor::Sample, this);
+    }
+}
+
+bool
+ConvergenceMonitor::CheckConvergence()
+{
+    uint32_t d = MserTruncation(m_throughput);
+    if (m_throughput.size() - d < m_params.minBatches)
+        return false;
+    BatchMeansInterval(m_throughput, d, m_tputMean, m_tputHw);
+
+    // Delay batches only exist where packets arrived; truncate them on their own.
+    uint32_t dd = MserTruncation(m_delay);
+    if (m_delay.size() - dd < m_params.minBatches)
+    {
+        // Nothing delivered at all is still a steady state.
+        if (!m_delay.empty() || m_tputMean > 0.0)
+            return false;
+        m_delayMean = m_delayHw = 0.0;
+    }
+    else
+    {
+        BatchMeansInterval(m_delay, dd, m_delayMean, m_delayHw);
+    }
+    m_truncated = d;
+
+    auto tight = [this](double mean, double hw) {
+        return hw <= m_params.relWidth * std::fabs(mean);
+    };
+    return tight(m_tputMean, m_tputHw) && tight(m_delayMean, m_delayHw);
+}
+
+bool
+ConvergenceMonitor::Converged() const
+{
+    return m_converged;
+}
+
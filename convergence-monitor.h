@@ -0,0 +1,60 @@
+#ifndef CONVERGENCE_MONITOR_H
+#define CONVERGENCE_MONITOR_H
+
+#include "ns3/core-module.h"
+#include "ns3/flow-monitor-module.h"
+
+#include <cstdint>
+#include <vector>
+
+// Steady-state detector for ns3_sim. Every `interval` seconds the aggregate
+// FlowMonitor counters are differenced into one batch (throughput, mean
+// delay). Once enough batches exist, the initial transient is truncated with
+// MSER and a batch-means confidence interval is computed on the rest; when
+// both metrics are within `relWidth` of their mean the simulation is stopped.
+class ConvergenceMonitor
+{
+  public:
+    struct Params
+    {
+        double interval = 0.5;    // batch length (s)
+        double relWidth = 0.05;   // target CI half-width / mean
+        uint32_t minBatches = 10; // batches required after truncation
+        double maxTime = 42.0;    // never sample past this time (s)
+    };
+
+    ConvergenceMonitor(ns3::Ptr<ns3::FlowMonitor> monitor, const Params& params);
+
+    // Begin sampling at `at`; the caller still schedules the hard stop.
+    void Start(ns3::Time at);
+
+    bool Converged() const;
+
+  private:
+    void Sample();
+    bool CheckConvergence();
+
+    ns3::Ptr<ns3::FlowMonitor> m_monitor;
+    Params m_params;
+    bool m_primed = false;
+    uint64_t m_lastRxBytes = 0;
+    uint64_t m_lastRxPackets = 0;
+    double m_lastDelaySum = 0.0;
+    std::vector<double> m_throughput; // Mbps per batch
+    std::vector<double> m_delay;      // ms per batch
+    bool m_converged = false;
+    uint32_t m_truncated = 0;
+    double m_tputMean = 0.0;
+    double m_tputHw = 0.0;
+    double m_delayMean = 0.0;
+    double m_delayHw = 0.0;
+};
+
+// MSER truncation point: the number of leading samples d (at most half the
+// series) minimising sum_{i>=d} (x_i - mean_d)^2 / (n - d)^2.
+uint32_t MserTruncation(const std::vector<double>& x);
+
+// Mean and 95% CI half-width of x[from..] treating each sample as a batch mean.
+void BatchMeansInterval(const std::vector<double>& x, uint32_t from, double& mean, double& hw);
+
+#endif // CONVERGENCE_MONITOR_H
@@ -0,0 +1,236 @@
+#include "drop-stats.h"
+
+#include "ns3/point-to-point-module.h"
+
+#include <fstream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("DropStats");
+
+DropCounter::DropCounter(const NodeContainer& nodes,
+                         const std::vector<NetDeviceContainer>& linkDevs,
+                         uint16_t basePort,
+                         const std::vector<std::pair<uint32_t, uint32_t>>& flowPairs)
+    : m_basePort(basePort),
+      m_flowPairs(flowPairs),
+      m_link(2 * linkDevs.size() * N_REASONS),
+      m_node(nodes.GetN() * N_REASONS),
+      m_flow(flowPairs.size() * N_REASONS),
+      m_lastQueueDrop(2 * linkDevs.size(), nullptr)
+{
+    using PacketTrace = Callback<void, Ptr<const Packet>>;
+    using QueueDiscTrace = Callback<void, Ptr<const QueueDiscItem>>;
+    using Ipv4DropTrace = Callback<void,
+                                   const Ipv4Header&,
+                                   Ptr<const Packet>,
+                                   Ipv4L3Protocol::DropReason,
+                                   Ptr<Ipv4>,
+                                   uint32_t>;
+
+    std::map<Ptr<Node>, uint32_t> index;
+    for (uint32_t n = 0; n < nodes.GetN(); ++n)
+    {
+        index[nodes.Get(n)] = n;
+        nodes.Get(n)->GetObject<Ipv4L3Protocol>()->TraceConnectWithoutContext(
+            "Drop",
+            Ipv4DropTrace([this, n](const Ipv4Header& h,
+                                    Ptr<const Packet> p,
+                                    Ipv4L3Protocol::DropReason reason,
+                                    Ptr<Ipv4>,
+                                    uint32_t) { IpDrop(n, h, p, reason); }));
+    }
+
+    for (uint32_t k = 0; k < linkDevs.size(); ++k)
+    {
+        uint32_t a = index[linkDevs[k].Get(0)->GetNode()];
+        uint32_t b = index[linkDevs[k].Get(1)->GetNode()];
+        m_linkEnds.emplace_back(a, b);
+        m_linkEnds.emplace_back(b, a);
+        for (uint32_t side = 0; side < 2; ++side)
+        {
+            Ptr<NetDevice> dev = linkDevs[k].Get(side);
+            uint32_t tx = 2 * k + side;     // packets this device sends
+            uint32_t rx = 2 * k + 1 - side; // packets this device receives
+            Ptr<PointToPointNetDevice> p2p = DynamicCast<PointToPointNetDevice>(dev);
+            p2p->GetQueue()->TraceConnectWithoutContext(
+                "Drop",
+                PacketTrace([this, tx](Ptr<const Packet> p) {
+                    LinkDrop(tx, QUEUE, p);
+                    m_lastQueueDrop[tx] = PeekPointer(p);
+                }));
+            dev->TraceConnectWithoutContext(
+                "MacTxDrop",
+                PacketTrace([this, tx](Ptr<const Packet> p) {
+                    // A full queue also fails the send; count that packet once
+                    if (m_lastQueueDrop[tx] != PeekPointer(p))
+                        LinkDrop(tx, MAC_TX, p);
+                    m_lastQueueDrop[tx] = nullptr;
+                }));
+            dev->TraceConnectWithoutContext(
+                "PhyRxDrop",
+                PacketTrace([this, rx](Ptr<const Packet> p) { LinkDrop(rx, PHY_RX, p); }));
+
+            Ptr<TrafficControlLayer> tc = dev->GetNode()->GetObject<TrafficControlLayer>();
+            Ptr<QueueDisc> qdisc = tc ? tc->GetRootQueueDiscOnDevice(dev) : nullptr;
+            if (qdisc)
+            {
+                qdisc->TraceConnectWithoutContext(
+                    "Drop",
+                    QueueDiscTrace(
+                        [this, tx](Ptr<const QueueDiscItem> item) { QueueDiscDrop(tx, item); }));
+            }
+        }
+    }
+}
+
+int64_t
+DropCounter::FlowOf(const Ipv4Header& header, Ptr<const Packet> payload) const
+{
+    if (header.GetProtocol() != UdpL4Protocol::PROT_NUMBER)
+        return -1;
+    UdpHeader udp;
+    payload->PeekHeader(udp);
+    int64_t flow = int64_t(udp.GetDestinationPort()) - m_basePort;
+    return flow >= 0 && flow < int64_t(m_flowPairs.size()) ? flow : -1;
+}
+
+void
+DropCounter::CountFlow(int64_t flow, Reason reason, uint32_t bytes)
+{
+    Count& c = flow >= 0 ? m_flow[flow * N_REASONS + reason] : m_unattributed[reason];
+    c.packets++;
+    c.bytes += bytes;
+}
+
+void
+DropCounter::LinkDrop(uint32_t directed, Reason reason, Ptr<const Packet> p)
+{
+    Count& c = m_link[directed * N_REASONS + reason];
+    c.packets++;
+    c.bytes += p->GetSize();
+
+    Ptr<Packet> copy = p->Copy();
+    Ipv4Header ip;
+    bool ipv4 = true;
+    if (reason != MAC_TX)
+    {
+        PppHeader ppp;
+        copy->RemoveHeader(ppp);
+        ipv4 = ppp.GetProtocol() == 0x0021;
+    }
+    int64_t flow = ipv4 && copy->RemoveHeader(ip) ? FlowOf(ip, copy) : -1;
+    CountFlow(flow, reason, p->GetSize());
+}
+
+void
+DropCounter::QueueDiscDrop(uint32_t directed, Ptr<const QueueDiscItem> item)
+{
+    Count& c = m_link[directed * N_REASONS + QDISC];
+    c.packets++;
+    c.bytes += item->GetSize();
+
+    Ptr<const Ipv4QueueDiscItem> ipItem = DynamicCast<const Ipv4QueueDiscItem>(item);
+    int64_t flow = ipItem ? FlowOf(ipItem->GetHeader(), ipItem->GetPacket()) : -1;
+    CountFlow(flow, QDISC, item->GetSize());
+}
+
+void
+DropCounter::IpDrop(uint32_t node,
+                    const Ipv4Header& header,
+                    Ptr<const Packet> p,
+                    Ipv4L3Protocol::DropReason reason)
+{
+    Reason r = OTHER;
+    switch (reason)
+    {
+    case Ipv4L3Protocol::DROP_TTL_EXPIRED:
+        r = TTL_EXPIRED;
+        break;
+    case Ipv4L3Protocol::DROP_NO_ROUTE:
+        r = NO_ROUTE;
+        break;
+    case Ipv4L3Protocol::DROP_ROUTE_ERROR:
+        r = ROUTE_ERROR;
+        break;
+    case Ipv4L3Protocol::DROP_INTERFACE_DOWN:
+        r = INTERFACE_DOWN;
+        break;
+    default:
+        break;
+    }
+    uint32_t bytes = p->GetSize() + header.GetSerializedSize();
+    Count& c = m_node[node * N_REASONS + r];
+    c.packets++;
+    c.bytes += bytes;
+    CountFlow(FlowOf(header, p), r, bytes);
+}
+
+const char*
+DropCounter::ReasonName(Reason reason)
+{
+    static const char* names[N_REASONS] = {"queue",
+                                           "qdisc",
+                                           "mac_tx",
+                                           "phy_rx",
+                                           "ttl_expired",
+                                           "no_route",
+                                           "route_error",
+                                           "interface_down",
+                                           "other"};
+    return names[reason];
+}
+
+uint64_t
+DropCounter::GetTotal(Reason reason) const
+{
+    // Every drop is counted once per flow (or as unattributed)
+    uint64_t n = m_unattributed[reason].packets;
+    for (size_t f = 0; f < m_flowPairs.size(); ++f)
+        n += m_flow[f * N_REASONS + reason].packets;
+    return n;
+}
+
+void
+DropCounter::Write(const std::string& file) const
+{
+    std::ofstream out(file);
+    out << "scope,id,src,dst,reason,packets,bytes\n";
+    auto row = [&](const char* scope,
+                   const std::string& id,
+                   const std::string& src,
+                   const std::string& dst,
+                   int r,
+                   const Count& c) {
+        if (c.packets > 0)
+            out << scope << "," << id << "," << src << "," << dst << ","
+                << ReasonName(Reason(r)) << "," << c.packets << "," << c.bytes << "\n";
+    };
+    for (size_t d = 0; d < m_linkEnds.size(); ++d)
+    {
+        for (int r = 0; r < N_REASONS; ++r)
+            row("link",
+                std::to_string(d / 2),
+                std::to_string(m_linkEnds[d].first),
+                std::to_string(m_linkEnds[d].second),
+                r,
+                m_link[d * N_REASONS + r]);
+    }
+    for (size_t n = 0; n < m_node.size() / N_REASONS; ++n)
+    {
+        for (int r = 0; r < N_REASONS; ++r)
+            row("node", std::to_string(n), "-", "-", r, m_node[n * N_REASONS + r]);
+    }
+    for (size_t f = 0; f < m_flowPairs.size(); ++f)
+    {
+        for (int r = 0; r < N_REASONS; ++r)
+            row("flow",
+                std::to_string(f),
+                std::to_string(m_flowPairs[f].first),
+                std::to_string(m_flowPairs[f].second),
+                r,
+                m_flow[f * N_REASONS + r]);
+    }
+    for (int r = 0; r < N_REASONS; ++r)
+        row("other", "-", "-", "-", r, m_unattributed[r]);
+}
@@ -0,0 +1,78 @@
+#ifndef DROP_STATS_H
+#define DROP_STATS_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Counts dropped packets by reason per directed link, per node and per flow.
+// Only drop traces are hooked (device queue Drop, MacTxDrop, PhyRxDrop, root
+// queue disc Drop and Ipv4L3Protocol Drop), so delivered packets cost
+// nothing; each drop bumps flat counter arrays. Flows are told apart by their
+// destination port (basePort + flow index), as installed by RunTraffic.
+class DropCounter
+{
+  public:
+    enum Reason
+    {
+        QUEUE,          // device transmit queue full
+        QDISC,          // queue disc (RED/CoDel/FqCoDel) drop
+        MAC_TX,         // device refused the packet: no channel attached
+        PHY_RX,         // receive error model, i.e. a failed link
+        TTL_EXPIRED,    // IPv4 TTL reached zero (a routing loop)
+        NO_ROUTE,       // no route, at the source or at a router
+        ROUTE_ERROR,    // routing error callback, e.g. arrival on a non-forwarding interface
+        INTERFACE_DOWN, // IPv4 interface down
+        OTHER,          // remaining IPv4 drop reasons
+        N_REASONS
+    };
+
+    // `linkDevs[k]` are the devices of link k (src side first).
+    DropCounter(const ns3::NodeContainer& nodes,
+                const std::vector<ns3::NetDeviceContainer>& linkDevs,
+                uint16_t basePort,
+                const std::vector<std::pair<uint32_t, uint32_t>>& flowPairs);
+
+    // Non-zero counters as scope,id,src,dst,reason,packets,bytes rows.
+    void Write(const std::string& file) const;
+    uint64_t GetTotal(Reason reason) const;
+
+    static const char* ReasonName(Reason reason);
+
+  private:
+    struct Count
+    {
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+    };
+
+    // Link drop: the packet carries its PPP header, except for MAC_TX drops,
+    // which the device reports before adding it.
+    void LinkDrop(uint32_t directed, Reason reason, ns3::Ptr<const ns3::Packet> p);
+    void QueueDiscDrop(uint32_t directed, ns3::Ptr<const ns3::QueueDiscItem> item);
+    void IpDrop(uint32_t node,
+                const ns3::Ipv4Header& header,
+                ns3::Ptr<const ns3::Packet> p,
+                ns3::Ipv4L3Protocol::DropReason reason);
+    // Flow index from the IPv4 header and UDP payload, or -1.
+    int64_t FlowOf(const ns3::Ipv4Header& header, ns3::Ptr<const ns3::Packet> payload) const;
+    void CountFlow(int64_t flow, Reason reason, uint32_t bytes);
+
+    uint16_t m_basePort;
+    std::vector<std::pair<uint32_t, uint32_t>> m_flowPairs;
+    std::vector<std::pair<uint32_t, uint32_t>> m_linkEnds; // directed: 2k src->dst, 2k+1 back
+    std::vector<Count> m_link;                              // directed link x reason
+    std::vector<Count> m_node;                              // node x reason
+    std::vector<Count> m_flow;                              // flow x reason
+    Count m_unattributed[N_REASONS];                        // ARP, ICMP, ...
+    std::vector<const ns3::Packet*> m_lastQueueDrop;        // per directed link
+};
+
+#endif // DROP_STATS_H
@@ -0,0 +1,215 @@
+#include "env-pool.h"
+
+#include "link-events.h"
+
+#include <cstdlib>
+#include <iostream>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("EnvPool");
+
+EnvPool::EnvPool(SimTopology& sim, const RunConfig& cfg, uint32_t nEnvs, uint32_t episodes)
+    : m_sim(sim),
+      m_cfg(cfg),
+      m_nEnvs(nEnvs),
+      m_episodes(episodes),
+      m_baseRun(RngSeedManager::GetRun()),
+      m_workers(nEnvs)
+{
+    m_cfg.DisableFileOutput();
+    if (m_sim.linkEvents)
+        m_sim.linkEvents->SetVerbose(false);
+}
+
+EnvPool::~EnvPool()
+{
+    CloseAll();
+}
+
+bool
+EnvPool::Spawn(uint32_t slot)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+    {
+        std::cerr << "socketpair() failed for slot " << slot << "\n";
+        return false;
+    }
+    uint32_t episode = m_started++;
+    EnvState& state = m_region.state[slot];
+    state.step = 0;
+    state.done = 0;
+    state.episode = episode;
+
+    std::cout.flush();
+    std::cerr.flush();
+    std::clog.flush();
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        std::cerr << "fork() failed for slot " << slot << "\n";
+        close(sv[0]);
+        close(sv[1]);
+        return false;
+    }
+    if (pid == 0)
+    {
+        // Keep only this worker's end, so the pool sees EOF when a worker dies
+        close(sv[0]);
+        close(m_agentFd);
+        close(m_listenFd);
+        for (const Worker& w : m_workers)
+        {
+            if (w.fd >= 0)
+                close(w.fd);
+        }
+        uint64_t run = m_baseRun + episode;
+        RngSeedManager::SetRun(run);
+        srand(static_cast<unsigned>(run));
+        RunConfig cfg = m_cfg;
+        cfg.envSlot = slot;
+        cfg.envFd = sv[1];
+        int rc = RunTraffic(m_sim, cfg);
+        std::cout.flush();
+        std::clog.flush();
+        _exit(rc);
+    }
+    close(sv[1]);
+    m_workers[slot] = Worker{pid, sv[0]};
+    return true;
+}
+
+void
+EnvPool::Reap(uint32_t slot)
+{
+    Worker& w = m_workers[slot];
+    close(w.fd);
+    int status = 0;
+    waitpid(w.pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        std::cerr << "Episode " << m_region.state[slot].episode << " (pid " << w.pid
+                  << ") failed\n";
+    w = Worker();
+}
+
+int
+EnvPool::Run()
+{
+    EnvHeader dims{};
+    dims.nEnvs = m_nEnvs;
+    dims.nNodes = m_sim.nNodes;
+    dims.nLinks = 2 * m_sim.linkDevs.size();
+    dims.nFlows = m_cfg.nFlows;
+    dims.maxActions = m_cfg.envMaxActions;
+    std::string shmFile = m_cfg.envSocket + ".shm";
+    if (!m_region.Create(shmFile, dims))
+        return 1;
+    for (uint32_t slot = 0; slot < m_nEnvs; ++slot)
+        m_region.state[slot].done = 2;
+
+    NS_LOG_UNCOND("[ENVPOOL] " << m_nEnvs << " environments, " << m_episodes
+                               << " episodes from RngRun " << m_baseRun
+                               << "; waiting for an agent on " << m_cfg.envSocket << " ("
+                               << m_region.size << " shared bytes)");
+    m_agentFd = EnvAccept(m_cfg.envSocket, m_listenFd);
+    if (m_agentFd < 0)
+        return 1;
+
+    for (uint32_t slot = 0; slot < m_nEnvs && m_started < m_episodes; ++slot)
+        Spawn(slot);
+
+    uint64_t step = 0;
+    uint32_t command = 1;
+    std::vector<bool> respawn(m_nEnvs, false);
+    while (command != 0)
+    {
+        // Every running worker publishes its step before the agent sees it.
+        // A finished slot is promised the next episode (done = 1) while
+        // episodes remain, so the agent can tell which final observation is
+        // the slot's last (done = 2).
+        uint32_t next = m_started;
+        uint32_t running = 0;
+        for (uint32_t slot = 0; slot < m_nEnvs; ++slot)
+        {
+            if (m_workers[slot].fd < 0)
+                continue;
+            uint64_t workerStep;
+            if (!EnvRecv(m_workers[slot].fd, &workerStep, sizeof(workerStep)))
+                m_region.state[slot].done = 1; // died; the agent sees a truncated episode
+            if (m_region.state[slot].done == 0)
+            {
+                running++;
+                continue;
+            }
+            Reap(slot);
+            respawn[slot] = next < m_episodes;
+            if (respawn[slot])
+                next++;
+            else
+                m_region.state[slot].done = 2;
+        }
+
+        step++;
+        if (!EnvSend(m_agentFd, &step, sizeof(step)))
+        {
+            NS_LOG_UNCOND("[ENVPOOL] Agent hung up at step " << step);
+            break;
+        }
+        if (running == 0 && next == m_started)
+            break; // every slot published its last observation
+        if (!EnvRecv(m_agentFd, &command, sizeof(command)))
+        {
+            NS_LOG_UNCOND("[ENVPOOL] Agent hung up at step " << step);
+            command = 0;
+        }
+        for (const Worker& w : m_workers)
+        {
+            if (w.fd >= 0)
+                EnvSend(w.fd, &command, sizeof(command));
+        }
+        for (uint32_t slot = 0; slot < m_nEnvs && command != 0; ++slot)
+        {
+            if (respawn[slot] && !Spawn(slot))
+                m_region.state[slot].done = 2;
+            respawn[slot] = false;
+        }
+    }
+
+    // Stopped workers publish a final observation on their way out
+    for (uint32_t slot = 0; slot < m_nEnvs; ++slot)
+    {
+        uint64_t workerStep;
+        if (m_workers[slot].fd < 0)
+            continue;
+        EnvRecv(m_workers[slot].fd, &workerStep, sizeof(workerStep));
+        Reap(slot);
+    }
+    NS_LOG_UNCOND("[ENVPOOL] " << m_started << " episodes in " << step << " steps");
+    CloseAll();
+    return 0;
+}
+
+void
+EnvPool::CloseAll()
+{
+    for (uint32_t slot = 0; slot < m_workers.size(); ++slot)
+    {
+        if (m_workers[slot].fd >= 0)
+            Reap(slot);
+    }
+    if (m_agentFd >= 0)
+        close(m_agentFd);
+    if (m_listenFd >= 0)
+    {
+        close(m_listenFd);
+        unlink(m_cfg.envSocket.c_str());
+    }
+    m_agentFd = -1;
+    m_listenFd = -1;
+    m_region.Unmap();
+}
@@ -0,0 +1,55 @@
+#ifndef ENV_POOL_H
+#define ENV_POOL_H
+
+#include "scenario.h"
+#include "step-env.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+// Batched step-wise control (--env=PATH --envPool=N): N forked workers each
+// run an episode of the built scenario (RngRun + episode number) as a
+// StepEnvironment joined to one slot of a shared PATH.shm, so every step's
+// observations sit in contiguous [N][...] arrays. The pool steps the workers
+// in lockstep: it waits for all of them to publish a step, hands the agent
+// one step message, and forwards the reply to each worker. A worker whose
+// episode ends (done = 1) is replaced by the next episode after the agent's
+// reply; once `episodes` have been started, a slot's last episode ends with
+// done = 2 and the slot stays idle. The pool hangs up after the step in which
+// every slot reached done = 2, without waiting for a reply.
+class EnvPool
+{
+  public:
+    EnvPool(SimTopology& sim, const RunConfig& cfg, uint32_t nEnvs, uint32_t episodes);
+    ~EnvPool();
+
+    // Wait for the agent, then run until the episodes finish or it stops.
+    int Run();
+
+  private:
+    struct Worker
+    {
+        pid_t pid = -1;
+        int fd = -1; // pool end of the worker's socket pair
+    };
+
+    bool Spawn(uint32_t slot);
+    void Reap(uint32_t slot);
+    void CloseAll();
+
+    SimTopology& m_sim;
+    RunConfig m_cfg;
+    uint32_t m_nEnvs;
+    uint32_t m_episodes;
+    uint32_t m_started = 0;
+    uint64_t m_baseRun;
+    std::vector<Worker> m_workers;
+    EnvRegion m_region;
+    int m_listenFd = -1;
+    int m_agentFd = -1;
+};
+
+#endif // ENV_POOL_H
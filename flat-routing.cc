@@ -0,0 +1,257 @@
+#include "flat-routing.h"
+
+#include <iomanip>
+#include <sstream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("FlatRouting");
+
+NS_OBJECT_ENSURE_REGISTERED(FlatRouting);
+
+static uint32_t
+PrefixMask(uint32_t len)
+{
+    return len == 0 ? 0 : ~0u << (32 - len);
+}
+
+TypeId
+FlatRouting::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::FlatRouting")
+                            .SetParent<Ipv4RoutingProtocol>()
+                            .SetGroupName("Internet")
+                            .AddConstructor<FlatRouting>();
+    return tid;
+}
+
+void
+FlatRouting::AddHostRoute(Ipv4Address dest, Ipv4Address gateway, uint32_t iface)
+{
+    m_hosts[dest.Get()] = Entry{gateway.Get(), iface};
+}
+
+void
+FlatRouting::AddNetworkRoute(Ipv4Address network,
+                             Ipv4Mask mask,
+                             Ipv4Address gateway,
+                             uint32_t iface)
+{
+    uint16_t len = mask.GetPrefixLength();
+    m_prefixes[len][network.Get() & PrefixMask(len)] = Entry{gateway.Get(), iface};
+    m_lengths |= uint64_t(1) << len;
+}
+
+void
+FlatRouting::ReserveHostRoutes(size_t n)
+{
+    m_hosts.reserve(m_hosts.size() + n);
+}
+
+void
+FlatRouting::ImportRoutes(const Ipv4GlobalRouting& global)
+{
+    for (uint32_t i = 0; i < global.GetNRoutes(); ++i)
+    {
+        const Ipv4RoutingTableEntry* r = global.GetRoute(i);
+        Entry e{r->GetGateway().Get(), r->GetInterface()};
+        if (r->IsHost())
+        {
+            m_hosts.emplace(r->GetDest().Get(), e);
+            continue;
+        }
+        uint16_t len = r->IsDefault() ? 0 : r->GetDestNetworkMask().GetPrefixLength();
+        m_prefixes[len].emplace(r->GetDestNetwork().Get() & PrefixMask(len), e);
+        m_lengths |= uint64_t(1) << len;
+    }
+}
+
+size_t
+FlatRouting::GetNNetworkRoutes() const
+{
+    size_t n = 0;
+    for (auto& table : m_prefixes)
+        n += table.size();
+    return n;
+}
+
+const FlatRouting::Entry*
+FlatRouting::Lookup(uint32_t dest) const
+{
+    auto host = m_hosts.find(dest);
+    if (host != m_hosts.end() && m_ipv4->IsUp(host->second.iface))
+        return &host->second;
+    for (int len = 32; len >= 0; --len)
+    {
+        if (!(m_lengths >> len & 1))
+            continue;
+        auto it = m_prefixes[len].find(dest & PrefixMask(len));
+        if (it != m_prefixes[len].end() && m_ipv4->IsUp(it->second.iface))
+            return &it->second;
+    }
+    return nullptr;
+}
+
+Ptr<Ipv4Route>
+FlatRouting::MakeRoute(Ipv4Address dest, const Entry& e) const
+{
+    Ptr<Ipv4Route> route = Create<Ipv4Route>();
+    route->SetDestination(dest);
+    route->SetGateway(Ipv4Address(e.gateway));
+    route->SetSource(m_ipv4->GetAddress(e.iface, 0).GetLocal());
+    route->SetOutputDevice(m_ipv4->GetNetDevice(e.iface));
+    return route;
+}
+
+Ptr<Ipv4Route>
+FlatRouting::RouteOutput(Ptr<Packet> p,
+                         const Ipv4Header& header,
+                         Ptr<NetDevice> oif,
+                         Socket::SocketErrno& sockerr)
+{
+    Ipv4Address dest = header.GetDestination();
+    const Entry* e = dest.IsMulticast() ? nullptr : Lookup(dest.Get());
+    if (!e || (oif && m_ipv4->GetNetDevice(e->iface) != oif))
+    {
+        sockerr = Socket::ERROR_NOROUTETOHOST;
+        return nullptr;
+    }
+    sockerr = Socket::ERROR_NOTERROR;
+    return MakeRoute(dest, *e);
+}
+
+bool
+FlatRouting::RouteInput(Ptr<const Packet> p,
+                        const Ipv4Header& header,
+                        Ptr<const NetDevice> idev,
+                        const UnicastForwardCallback& ucb,
+                        const MulticastForwardCallback& mcb,
+                        const LocalDeliverCallback& lcb,
+                        const ErrorCallback& ecb)
+{
+    Ipv4Address dest = header.GetDestination();
+    if (dest.IsMulticast())
+        return false;
+
+    uint32_t iif = m_ipv4->GetInterfaceForDevice(idev);
+    if (m_ipv4->IsDestinationAddress(dest, iif))
+    {
+        if (lcb.IsNull())
+            return false;
+        lcb(p, header, iif);
+        return true;
+    }
+    if (!m_ipv4->IsForwarding(iif))
+    {
+        ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+        return true;
+    }
+
+    const Entry* e = Lookup(dest.Get());
+    if (!e)
+        return false;
+    ucb(MakeRoute(dest, *e), p, header);
+    return true;
+}
+
+void
+FlatRouting::SetConnected(uint32_t iface, Ipv4InterfaceAddress address, bool add)
+{
+    uint16_t len = address.GetMask().GetPrefixLength();
+    uint32_t key = address.GetLocal().Get() & PrefixMask(len);
+    if (add)
+    {
+        m_prefixes[len][key] = Entry{0, iface};
+        m_lengths |= uint64_t(1) << len;
+        return;
+    }
+    auto it = m_prefixes[len].find(key);
+    if (it != m_prefixes[len].end() && it->second.iface == iface && it->second.gateway == 0)
+        m_prefixes[len].erase(it);
+    if (m_prefixes[len].empty())
+        m_lengths &= ~(uint64_t(1) << len);
+}
+
+void
+FlatRouting::NotifyInterfaceUp(uint32_t iface)
+{
+    for (uint32_t j = 0; j < m_ipv4->GetNAddresses(iface); ++j)
+        SetConnected(iface, m_ipv4->GetAddress(iface, j), true);
+}
+
+void
+FlatRouting::NotifyInterfaceDown(uint32_t iface)
+{
+    // Routes via a down interface are skipped by Lookup; only forget connectivity
+    for (uint32_t j = 0; j < m_ipv4->GetNAddresses(iface); ++j)
+        SetConnected(iface, m_ipv4->GetAddress(iface, j), false);
+}
+
+void
+FlatRouting::NotifyAddAddress(uint32_t iface, Ipv4InterfaceAddress address)
+{
+    if (m_ipv4->IsUp(iface))
+        SetConnected(iface, address, true);
+}
+
+void
+FlatRouting::NotifyRemoveAddress(uint32_t iface, Ipv4InterfaceAddress address)
+{
+    SetConnected(iface, address, false);
+}
+
+void
+FlatRouting::SetIpv4(Ptr<Ipv4> ipv4)
+{
+    m_ipv4 = ipv4;
+    for (uint32_t i = 0; i < m_ipv4->GetNInterfaces(); ++i)
+    {
+        if (m_ipv4->IsUp(i))
+            NotifyInterfaceUp(i);
+    }
+}
+
+void
+FlatRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+{
+    std::ostream& os = *stream->GetStream();
+    os << "FlatRouting: " << m_hosts.size() << " host routes, " << GetNNetworkRoutes()
+       << " network routes\n";
+    auto print = [&](uint32_t dest, uint32_t len, const Entry& e) {
+        std::ostringstream d;
+        Ipv4Address(dest).Print(d);
+        d << "/" << len;
+        os << std::setw(20) << std::left << d.str();
+        Ipv4Address(e.gateway).Print(os);
+        os << " if " << e.iface << "\n";
+    };
+    for (auto& kv : m_hosts)
+        print(kv.first, 32, kv.second);
+    for (int len = 32; len >= 0; --len)
+    {
+        for (auto& kv : m_prefixes[len])
+            print(kv.first, len, kv.second);
+    }
+}
+
+void
+FlatRouting::DoDispose()
+{
+    m_ipv4 = nullptr;
+    m_hosts.clear();
+    for (auto& table : m_prefixes)
+        table.clear();
+    Ipv4RoutingProtocol::DoDispose();
+}
+
+FlatRoutingHelper*
+FlatRoutingHelper::Copy() const
+{
+    return new FlatRoutingHelper(*this);
+}
+
+Ptr<Ipv4RoutingProtocol>
+FlatRoutingHelper::Create(Ptr<Node> node) const
+{
+    return CreateObject<FlatRouting>();
+}
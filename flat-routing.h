@@ -0,0 +1,105 @@
+#ifndef FLAT_ROUTING_H
+#define FLAT_ROUTING_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+// Unicast routing with lookups that do not grow with the table (--routing=flat).
+// Host routes live in one hash table keyed by destination; prefix routes in one
+// hash table per prefix length, probed longest first over the lengths actually
+// present (a handful: /32, /24, /8 for loopback). Ipv4StaticRouting scans its
+// whole route list for every packet instead.
+//
+// Installed in the list routing below Ipv4StaticRouting (which then only holds
+// connected routes and link-event repairs) and above Ipv4GlobalRouting, whose
+// computed routes are imported in bulk so global routing is only a fallback.
+class FlatRouting : public ns3::Ipv4RoutingProtocol
+{
+  public:
+    static ns3::TypeId GetTypeId();
+
+    // Replaces any earlier host route to `dest` (last one wins, as with
+    // equal-metric static routes).
+    void AddHostRoute(ns3::Ipv4Address dest, ns3::Ipv4Address gateway, uint32_t iface);
+    void AddNetworkRoute(ns3::Ipv4Address network,
+                         ns3::Ipv4Mask mask,
+                         ns3::Ipv4Address gateway,
+                         uint32_t iface);
+    // Size the host table for a bulk load.
+    void ReserveHostRoutes(size_t n);
+    // Copy the routes global routing computed for this node; existing
+    // entries (connected networks, earlier imports) are kept.
+    void ImportRoutes(const ns3::Ipv4GlobalRouting& global);
+
+    size_t GetNNetworkRoutes() const;
+
+    ns3::Ptr<ns3::Ipv4Route> RouteOutput(ns3::Ptr<ns3::Packet> p,
+                                         const ns3::Ipv4Header& header,
+                                         ns3::Ptr<ns3::NetDevice> oif,
+                                         ns3::Socket::SocketErrno& sockerr) override;
+    bool RouteInput(ns3::Ptr<const ns3::Packet> p,
+                    const ns3::Ipv4Header& header,
+                    ns3::Ptr<const ns3::NetDevice> idev,
+                    const UnicastForwardCallback& ucb,
+                    const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb,
+                    const ErrorCallback& ecb) override;
+    void NotifyInterfaceUp(uint32_t iface) override;
+    void NotifyInterfaceDown(uint32_t iface) override;
+    void NotifyAddAddress(uint32_t iface, ns3::Ipv4InterfaceAddress address) override;
+    void NotifyRemoveAddress(uint32_t iface, ns3::Ipv4InterfaceAddress address) override;
+    void SetIpv4(ns3::Ptr<ns3::Ipv4> ipv4) override;
+    void PrintRoutingTable(ns3::Ptr<ns3::OutputStreamWrapper> stream,
+                           ns3::Time::Unit unit = ns3::Time::S) const override;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    struct Entry
+    {
+        uint32_t gateway; // 0 = directly connected
+        uint32_t iface;
+    };
+
+    // Longest match whose interface is up, or nullptr.
+    const Entry* Lookup(uint32_t dest) const;
+    ns3::Ptr<ns3::Ipv4Route> MakeRoute(ns3::Ipv4Address dest, const Entry& e) const;
+    void SetConnected(uint32_t iface, ns3::Ipv4InterfaceAddress address, bool add);
+
+    ns3::Ptr<ns3::Ipv4> m_ipv4;
+    std::unordered_map<uint32_t, Entry> m_hosts;
+    std::unordered_map<uint32_t, Entry> m_prefixes[33]; // by prefix length
+    uint64_t m_lengths = 0;                             // bit L: m_prefixes[L] non-empty
+};
+
+class FlatRoutingHelper : public ns3::Ipv4RoutingHelper
+{
+  public:
+    FlatRoutingHelper* Copy() const override;
+    ns3::Ptr<ns3::Ipv4RoutingProtocol> Create(ns3::Ptr<ns3::Node> node) const override;
+};
+
+// Protocol of type T on `ipv4`, directly or inside its Ipv4ListRouting.
+template <class T>
+ns3::Ptr<T>
+FindRoutingProtocol(ns3::Ptr<ns3::Ipv4> ipv4)
+{
+    ns3::Ptr<ns3::Ipv4RoutingProtocol> rp = ipv4->GetRoutingProtocol();
+    if (ns3::Ptr<T> direct = ns3::DynamicCast<T>(rp))
+        return direct;
+    ns3::Ptr<ns3::Ipv4ListRouting> list = ns3::DynamicCast<ns3::Ipv4ListRouting>(rp);
+    for (uint32_t i = 0; list && i < list->GetNRoutingProtocols(); ++i)
+    {
+        int16_t priority;
+        if (ns3::Ptr<T> p = ns3::DynamicCast<T>(list->GetRoutingProtocol(i, priority)))
+            return p;
+    }
+    return nullptr;
+}
+
+#endif // FLAT_ROUTING_H
@@ -0,0 +1,58 @@
+#ifndef FLOW_WINDOWS_H
+#define FLOW_WINDOWS_H
+
+#include "ns3/core-module.h"
+#include "ns3/flow-monitor-module.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Cumulative per-flow counters at one instant (a FlowMonitor::FlowStats subset).
+struct FlowCounters
+{
+    uint32_t txPackets = 0;
+    uint32_t rxPackets = 0;
+    uint64_t txBytes = 0;
+    uint64_t rxBytes = 0;
+    double delaySum = 0.0; // seconds
+
+    FlowCounters operator-(const FlowCounters& o) const;
+};
+
+// Snapshots FlowMonitor counters at measurement window boundaries so that the
+// start-up transient (before `warmup`) and the teardown (after `end`) can be
+// excluded. Window i covers [Boundary(i), Boundary(i + 1)).
+class FlowWindowRecorder
+{
+  public:
+    FlowWindowRecorder(ns3::Ptr<ns3::FlowMonitor> monitor,
+                       double warmup,
+                       double interval,
+                       double end);
+
+    // Schedule boundary snapshots at warmup, warmup + interval, ... <= end,
+    // and at end itself if the last of them falls short of it.
+    void Start();
+    // Close a trailing partial window if the run stopped before end.
+    void Finish();
+
+    // Number of complete or partial windows recorded.
+    uint32_t GetNWindows() const;
+    double GetBoundary(uint32_t i) const;
+    // Counter delta of `id` over windows [from, to).
+    FlowCounters Delta(ns3::FlowId id, uint32_t from, uint32_t to) const;
+
+  private:
+    void Snapshot();
+    void Record();
+
+    ns3::Ptr<ns3::FlowMonitor> m_monitor;
+    double m_warmup;
+    double m_interval;
+    double m_end;
+    std::vector<double> m_times;
+    std::vector<std::map<ns3::FlowId, FlowCounters>> m_snapshots;
+};
+
+#endif // FLOW_WINDOWS_H
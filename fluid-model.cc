@@ -0,0 +1,229 @@
+#include "fluid-model.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("FluidModel");
+
+FluidModel::FluidModel(uint32_t nNodes,
+                       const std::vector<LinkSpec>& links,
+                       uint32_t packetSize,
+                       const std::vector<double>& bufferPackets)
+    : m_nNodes(nNodes),
+      m_packetSize(packetSize),
+      m_adj(nNodes)
+{
+    for (size_t k = 0; k < links.size(); ++k)
+    {
+        const LinkSpec& lk = links[k];
+        if (lk.src >= nNodes || lk.dst >= nNodes)
+            continue;
+        double bps = DataRate(lk.bw).GetBitRate();
+        double prop = Time(lk.delay).GetSeconds();
+        for (int dir = 0; dir < 2; ++dir)
+        {
+            uint32_t from = dir ? lk.dst : lk.src;
+            uint32_t to = dir ? lk.src : lk.dst;
+            m_adj[from].push_back(m_linkFrom.size());
+            m_linkFrom.push_back(from);
+            m_linkTo.push_back(to);
+            m_capacity.push_back(bps);
+            m_propDelay.push_back(prop);
+            m_buffer.push_back(bufferPackets[k]);
+        }
+    }
+    m_load.assign(m_capacity.size(), 0.0);
+    m_offered.assign(m_capacity.size(), 0.0);
+}
+
+bool
+FluidModel::BuildPath(const std::vector<uint32_t>& path, std::vector<uint32_t>& dirLinks) const
+{
+    dirLinks.clear();
+    for (size_t i = 0; i + 1 < path.size(); ++i)
+    {
+        if (path[i] >= m_nNodes)
+            return false;
+        bool found = false;
+        for (uint32_t l : m_adj[path[i]])
+        {
+            if (m_linkTo[l] == path[i + 1])
+            {
+                dirLinks.push_back(l);
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            return false;
+    }
+    return !dirLinks.empty();
+}
+
+bool
+FluidModel::ShortestPath(uint32_t src, uint32_t dst, std::vector<uint32_t>& dirLinks) const
+{
+    std::vector<int64_t> via(m_nNodes, -1);
+    std::vector<bool> seen(m_nNodes, false);
+    std::queue<uint32_t> q;
+    q.push(src);
+    seen[src] = true;
+    while (!q.empty() && !seen[dst])
+    {
+        uint32_t u = q.front();
+        q.pop();
+        for (uint32_t l : m_adj[u])
+        {
+            uint32_t v = m_linkTo[l];
+            if (!seen[v])
+            {
+                seen[v] = true;
+                via[v] = l;
+                q.push(v);
+            }
+        }
+    }
+    if (!seen[dst])
+        return false;
+
+    dirLinks.clear();
+    for (uint32_t v = dst; v != src; v = m_linkFrom[via[v]])
+        dirLinks.push_back(via[v]);
+    std::reverse(dirLinks.begin(), dirLinks.end());
+    return true;
+}
+
+int32_t
+FluidModel::AddFlow(uint32_t src,
+                    uint32_t dst,
+                    double demandBps,
+                    const std::vector<uint32_t>& path)
+{
+    if (src >= m_nNodes || dst >= m_nNodes || src == dst)
+        return -1;
+
+    std::vector<uint32_t> dirLinks;
+    bool ok = !path.empty() && path.front() == src && path.back() == dst &&
+              BuildPath(path, dirLinks);
+    if (!ok && !ShortestPath(src, dst, dirLinks))
+        return -1;
+
+    m_flowLinks.insert(m_flowLinks.end(), dirLinks.begin(), dirLinks.end());
+    m_flowOffset.push_back(m_flowLinks.size());
+    m_demand.push_back(demandBps);
+    return m_demand.size() - 1;
+}
+
+void
+FluidModel::Solve()
+{
+    const uint32_t nLinks = m_capacity.size();
+    const uint32_t nFlows = m_demand.size();
+    const double inf = std::numeric_limits<double>::infinity();
+
+    std::vector<double> residual(m_capacity);
+    std::vector<double> active(nLinks, 0.0); // unfrozen flows per link, as double for SIMD
+    std::vector<uint8_t> frozen(nFlows, 0);
+    m_rate.assign(nFlows, 0.0);
+    std::fill(m_offered.begin(), m_offered.end(), 0.0);
+
+    uint32_t nUnfrozen = 0;
+    for (uint32_t f = 0; f < nFlows; ++f)
+    {
+        if (m_demand[f] <= 0.0)
+        {
+            frozen[f] = 1;
+            continue;
+        }
+        nUnfrozen++;
+        for (uint32_t i = m_flowOffset[f]; i < m_flowOffset[f + 1]; ++i)
+        {
+            active[m_flowLinks[i]] += 1.0;
+            m_offered[m_flowLinks[i]] += m_demand[f];
+        }
+    }
+
+    std::vector<double> share(nLinks);
+    while (nUnfrozen > 0)
+    {
+        // Largest common increment: the tightest link's equal share or the
+        // smallest unmet demand.
+        for (uint32_t l = 0; l < nLinks; ++l)
+            share[l] = active[l] > 0.0 ? residual[l] / active[l] : inf;
+        double inc = *std::min_element(share.begin(), share.end());
+        for (uint32_t f = 0; f < nFlows; ++f)
+        {
+            if (!frozen[f])
+                inc = std::min(inc, m_demand[f] - m_rate[f]);
+        }
+        inc = std::max(inc, 0.0);
+
+        for (uint32_t f = 0; f < nFlows; ++f)
+            m_rate[f] += frozen[f] ? 0.0 : inc;
+        for (uint32_t l = 0; l < nLinks; ++l)
+            residual[l] -= inc * active[l];
+
+        // Freeze flows that met their demand or cross a saturated link.
+        for (uint32_t f = 0; f < nFlows; ++f)
+        {
+            if (frozen[f])
+                continue;
+            bool done = m_rate[f] >= m_demand[f] * (1.0 - 1e-9);
+            for (uint32_t i = m_flowOffset[f]; !done && i < m_flowOffset[f + 1]; ++i)
+            {
+                uint32_t l = m_flowLinks[i];
+                done = residual[l] <= m_capacity[l] * 1e-9;
+            }
+            if (done)
+            {
+                frozen[f] = 1;
+                nUnfrozen--;
+                for (uint32_t i = m_flowOffset[f]; i < m_flowOffset[f + 1]; ++i)
+                    active[m_flowLinks[i]] -= 1.0;
+            }
+        }
+    }
+
+    for (uint32_t l = 0; l < nLinks; ++l)
+        m_load[l] = m_capacity[l] - residual[l];
+
+    // Per-link delay: propagation + serialisation + queueing. Overloaded links
+    // (offered > capacity) sit at their saturated occupancy; otherwise M/M/1,
+    // still bounded by it.
+    std::vector<double> linkDelay(nLinks);
+    for (uint32_t l = 0; l < nLinks; ++l)
+    {
+        double tx = m_packetSize * 8.0 / m_capacity[l];
+        double rho = std::min(m_load[l] / m_capacity[l], 1.0);
+        double queued = m_buffer[l];
+        if (m_offered[l] < m_capacity[l] && rho < 1.0)
+            queued = std::min(rho * rho / (1.0 - rho), m_buffer[l]);
+        linkDelay[l] = m_propDelay[l] + tx + queued * tx;
+    }
+
+    m_delay.assign(nFlows, 0.0);
+    for (uint32_t f = 0; f < nFlows; ++f)
+    {
+        for (uint32_t i = m_flowOffset[f]; i < m_flowOffset[f + 1]; ++i)
+            m_delay[f] += linkDelay[m_flowLinks[i]];
+    }
+}
+
+double
+FluidModel::GetRate(uint32_t flow) const
+{
+    return m_rate[flow];
+}
+
+double
+FluidModel::GetDelay(uint32_t flow) const
+{
+    return m_delay[flow];
+}
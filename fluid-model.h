@@ -0,0 +1,62 @@
+#ifndef FLUID_MODEL_H
+#define FLUID_MODEL_H
+
+#include "topology-spec.h"
+
+#include <cstdint>
+#include <vector>
+
+// Flow-level (fluid) approximation of a ns3_sim scenario for fast screening of
+// routings. Every topology link becomes two directed links; flows get max-min
+// fair rates capped by their offered load (progressive filling), and delay is
+// propagation + serialisation + an M/M/1 queueing estimate bounded by each
+// link's saturated queue occupancy. Per-link state is kept in flat arrays so the filling loops
+// vectorise.
+class FluidModel
+{
+  public:
+    // `bufferPackets[k]` is the standing queue of topology link k when saturated.
+    FluidModel(uint32_t nNodes,
+               const std::vector<LinkSpec>& links,
+               uint32_t packetSize,
+               const std::vector<double>& bufferPackets);
+
+    // Add a flow offering `demandBps`. `path` lists nodes src..dst; if it is
+    // empty or not a walk over existing links the min-hop path is used.
+    // Returns the flow index, or -1 if dst is unreachable.
+    int32_t AddFlow(uint32_t src,
+                    uint32_t dst,
+                    double demandBps,
+                    const std::vector<uint32_t>& path);
+
+    void Solve();
+
+    double GetRate(uint32_t flow) const;  // bit/s
+    double GetDelay(uint32_t flow) const; // seconds
+
+  private:
+    bool BuildPath(const std::vector<uint32_t>& path, std::vector<uint32_t>& dirLinks) const;
+    bool ShortestPath(uint32_t src, uint32_t dst, std::vector<uint32_t>& dirLinks) const;
+
+    uint32_t m_nNodes;
+    uint32_t m_packetSize;
+
+    // Directed links: 2k is src->dst of topology link k, 2k+1 the reverse.
+    std::vector<uint32_t> m_linkFrom;
+    std::vector<uint32_t> m_linkTo;
+    std::vector<double> m_capacity;           // bit/s
+    std::vector<double> m_propDelay;          // s
+    std::vector<double> m_buffer;             // packets queued when saturated
+    std::vector<double> m_load;               // bit/s carried after Solve()
+    std::vector<double> m_offered;            // bit/s offered before drops
+    std::vector<std::vector<uint32_t>> m_adj; // node -> outgoing directed links
+
+    // Flow -> directed links in CSR form.
+    std::vector<uint32_t> m_flowOffset{0};
+    std::vector<uint32_t> m_flowLinks;
+    std::vector<double> m_demand;
+    std::vector<double> m_rate;
+    std::vector<double> m_delay;
+};
+
+#endif // FLUID_MODEL_H
@@ -0,0 +1,118 @@
+#include "fork-pool.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+ForkPool::ForkPool(uint32_t maxJobs)
+    : m_maxJobs(maxJobs)
+{
+    if (m_maxJobs == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        m_maxJobs = cpus > 0 ? static_cast<uint32_t>(cpus) : 1;
+    }
+}
+
+uint32_t
+ForkPool::GetMaxJobs() const
+{
+    return m_maxJobs;
+}
+
+uint32_t
+ForkPool::Run(uint32_t first, uint32_t count, const Work& work, const Done& done)
+{
+    struct Child
+    {
+        uint32_t task;
+        FILE* out;
+    };
+
+    std::map<pid_t, Child> running;
+    uint32_t failures = 0;
+    auto reapOne = [&]() {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        while (pid < 0 && errno == EINTR)
+            pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+        {
+            // ECHILD: the children were reaped elsewhere and their exit
+            // status is lost; fail them rather than wait forever
+            std::cerr << "waitpid() failed: " << std::strerror(errno) << "\n";
+            for (auto& kv : running)
+            {
+                fclose(kv.second.out);
+                failures++;
+                done(kv.second.task, false, "");
+            }
+            running.clear();
+            return;
+        }
+        auto it = running.find(pid);
+        if (it == running.end())
+            return;
+
+        std::string output;
+        char buf[4096];
+        size_t n;
+        rewind(it->second.out);
+        while ((n = fread(buf, 1, sizeof(buf), it->second.out)) > 0)
+            output.append(buf, n);
+        fclose(it->second.out);
+
+        bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        if (!ok)
+        {
+            std::cerr << "Task " << it->second.task << " (pid " << pid << ") failed\n";
+            failures++;
+        }
+        uint32_t task = it->second.task;
+        running.erase(it);
+        done(task, ok, output);
+    };
+
+    for (uint32_t task = first; task < first + count; ++task)
+    {
+        while (running.size() >= m_maxJobs)
+            reapOne();
+
+        FILE* out = tmpfile();
+        std::cout.flush();
+        std::cerr.flush();
+        std::clog.flush();
+        pid_t pid = out ? fork() : -1;
+        if (pid < 0)
+        {
+            std::cerr << "fork() failed for task " << task << "\n";
+            if (out)
+                fclose(out);
+            failures++;
+            done(task, false, "");
+            continue;
+        }
+        if (pid == 0)
+        {
+            std::ostringstream oss;
+            int rc = work(task, oss);
+            std::string s = oss.str();
+            fwrite(s.data(), 1, s.size(), out);
+            fflush(out);
+            std::cout.flush();
+            std::clog.flush();
+            _exit(rc);
+        }
+        running[pid] = Child{task, out};
+    }
+    while (!running.empty())
+        reapOne();
+
+    return failures;
+}
@@ -0,0 +1,33 @@
+#ifndef FORK_POOL_H
+#define FORK_POOL_H
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
+// Runs tasks in forked children that share the parent's memory copy-on-write,
+// at most `maxJobs` at a time. Whatever a child writes to its stream is handed
+// back to the parent when the child exits (through an unlinked temp file, so
+// output size is not limited by pipe buffers).
+class ForkPool
+{
+  public:
+    // Child body: returns the process exit code.
+    using Work = std::function<int(uint32_t task, std::ostream& out)>;
+    // Parent callback, in completion order; ok is false on non-zero exit.
+    using Done = std::function<void(uint32_t task, bool ok, const std::string& output)>;
+
+    // maxJobs = 0 uses one job per online CPU.
+    explicit ForkPool(uint32_t maxJobs);
+
+    uint32_t GetMaxJobs() const;
+
+    // Run tasks [first, first + count). Returns the number that failed.
+    uint32_t Run(uint32_t first, uint32_t count, const Work& work, const Done& done);
+
+  private:
+    uint32_t m_maxJobs;
+};
+
+#endif // FORK_POOL_H
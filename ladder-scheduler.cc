@@ -0,0 +1,188 @@
+#include "ladder-scheduler.h"
+
+#include <algorithm>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED(LadderScheduler);
+
+TypeId
+LadderScheduler::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::LadderScheduler")
+                            .SetParent<Scheduler>()
+                            .SetGroupName("Core")
+                            .AddConstructor<LadderScheduler>();
+    return tid;
+}
+
+uint64_t
+LadderScheduler::Rung::CurStart() const
+{
+    return start + cur * width;
+}
+
+uint32_t
+LadderScheduler::Rung::BucketOf(uint64_t ts) const
+{
+    uint64_t k = (ts - start) / width;
+    return static_cast<uint32_t>(std::min<uint64_t>(k, buckets.size() - 1));
+}
+
+void
+LadderScheduler::Insert(const Event& ev)
+{
+    uint64_t ts = ev.key.m_ts;
+    if (ts >= m_topStart)
+    {
+        m_top.push_back(ev);
+        m_topMin = std::min(m_topMin, ts);
+        m_topMax = std::max(m_topMax, ts);
+    }
+    else
+    {
+        // Rungs hold consecutive ranges, coarsest (latest) first
+        auto rung = std::find_if(m_rungs.begin(), m_rungs.end(), [ts](const Rung& r) {
+            return ts >= r.CurStart();
+        });
+        if (rung != m_rungs.end())
+            rung->buckets[rung->BucketOf(ts)].push_back(ev);
+        else
+            InsertBottom(ev);
+    }
+    if (m_head == m_bottom.size())
+        Refill();
+}
+
+bool
+LadderScheduler::IsEmpty() const
+{
+    return m_head == m_bottom.size();
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext() const
+{
+    NS_ASSERT(!IsEmpty());
+    return m_bottom[m_head];
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext()
+{
+    NS_ASSERT(!IsEmpty());
+    Event ev = m_bottom[m_head++];
+    if (m_head == m_bottom.size())
+        Refill();
+    return ev;
+}
+
+void
+LadderScheduler::Remove(const Event& ev)
+{
+    uint64_t ts = ev.key.m_ts;
+    auto same = [&ev](const Event& e) { return e.key.m_uid == ev.key.m_uid; };
+    auto erase = [&same](std::vector<Event>& events) {
+        auto it = std::find_if(events.begin(), events.end(), same);
+        NS_ASSERT_MSG(it != events.end(), "Event not found");
+        *it = events.back();
+        events.pop_back();
+    };
+
+    if (ts >= m_topStart)
+    {
+        erase(m_top);
+        return;
+    }
+    for (Rung& r : m_rungs)
+    {
+        if (ts >= r.CurStart())
+        {
+            erase(r.buckets[r.BucketOf(ts)]);
+            return;
+        }
+    }
+    auto it = std::lower_bound(m_bottom.begin() + m_head, m_bottom.end(), ev);
+    NS_ASSERT_MSG(it != m_bottom.end() && same(*it), "Event not found");
+    m_bottom.erase(it);
+    if (m_head == m_bottom.size())
+        Refill();
+}
+
+void
+LadderScheduler::InsertBottom(const Event& ev)
+{
+    // Newer events usually sort last, so this is mostly an append
+    m_bottom.insert(std::upper_bound(m_bottom.begin() + m_head, m_bottom.end(), ev), ev);
+    if (m_bottom.size() - m_head <= kThreshold || m_rungs.size() >= kMaxRungs)
+        return;
+    // Bottom is below every rung, so its events make a valid new lowest rung;
+    // a single timestamp cannot be spread
+    uint64_t first = m_bottom[m_head].key.m_ts;
+    uint64_t last = m_bottom.back().key.m_ts;
+    if (first == last)
+        return;
+    std::vector<Event> events(m_bottom.begin() + m_head, m_bottom.end());
+    m_bottom.clear();
+    m_head = 0;
+    AddRung(first, last - first + 1, events);
+    Refill();
+}
+
+void
+LadderScheduler::AddRung(uint64_t start, uint64_t span, std::vector<Event>& events)
+{
+    // About one event per bucket
+    uint64_t width = (span + events.size() - 1) / events.size();
+    Rung rung{start, width, 0, {}};
+    rung.buckets.resize((span + width - 1) / width);
+    for (const Event& ev : events)
+        rung.buckets[rung.BucketOf(ev.key.m_ts)].push_back(ev);
+    m_rungs.push_back(std::move(rung));
+}
+
+void
+LadderScheduler::Refill()
+{
+    m_bottom.clear();
+    m_head = 0;
+    while (m_bottom.empty())
+    {
+        if (m_rungs.empty())
+        {
+            if (m_top.empty())
+                return;
+            std::vector<Event> top;
+            top.swap(m_top);
+            AddRung(m_topMin, m_topMax - m_topMin + 1, top);
+            const Rung& rung = m_rungs.back();
+            m_topStart = rung.start + rung.width * rung.buckets.size();
+            m_topMin = UINT64_MAX;
+            m_topMax = 0;
+            continue;
+        }
+
+        Rung& rung = m_rungs.back();
+        while (rung.cur < rung.buckets.size() && rung.buckets[rung.cur].empty())
+            rung.cur++;
+        if (rung.cur == rung.buckets.size())
+        {
+            m_rungs.pop_back();
+            continue;
+        }
+        std::vector<Event> bucket;
+        bucket.swap(rung.buckets[rung.cur]);
+        uint64_t start = rung.CurStart();
+        uint64_t width = rung.width;
+        rung.cur++;
+        if (bucket.size() > kThreshold && width > 1 && m_rungs.size() < kMaxRungs)
+        {
+            AddRung(start, width, bucket);
+            continue;
+        }
+        std::sort(bucket.begin(), bucket.end());
+        m_bottom.swap(bucket);
+    }
+}
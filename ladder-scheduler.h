@@ -0,0 +1,63 @@
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "ns3/core-module.h"
+
+#include <cstdint>
+#include <vector>
+
+// Ladder queue event scheduler (Tang, Goh and Thng, 2005), selected with
+// --scheduler=ladder. Far-future events are appended unsorted to Top. When
+// the near future runs dry, Top is spread over a rung of buckets one event
+// wide on average; the first non-empty bucket is sorted into Bottom, or split
+// into a finer rung if it is crowded. Only Bottom is ever sorted. Events that
+// land below every rung are inserted there in order, and once it holds more
+// than kThreshold it is spread over a new rung again (the paper's Bottom
+// overflow), so it stays about a bucket's worth. Insert and remove are then
+// O(1) amortized for the bursts of near-future packet events ns3_sim
+// produces, where the map and heap schedulers pay O(log n).
+class LadderScheduler : public ns3::Scheduler
+{
+  public:
+    static ns3::TypeId GetTypeId();
+
+    void Insert(const Event& ev) override;
+    bool IsEmpty() const override;
+    Event PeekNext() const override;
+    Event RemoveNext() override;
+    void Remove(const Event& ev) override;
+
+  private:
+    struct Rung
+    {
+        uint64_t start; // timestamp of bucket 0
+        uint64_t width; // timestamps per bucket
+        uint32_t cur;   // first bucket not yet moved down
+        std::vector<std::vector<Event>> buckets;
+
+        // Start of the time range still held by this rung.
+        uint64_t CurStart() const;
+        // Bucket for `ts`; the last bucket also takes everything beyond.
+        uint32_t BucketOf(uint64_t ts) const;
+    };
+
+    static const uint32_t kMaxRungs = 8;
+    static const uint32_t kThreshold = 50; // bucket or Bottom size that earns a finer rung
+
+    // Keep Bottom non-empty while any event is queued, so PeekNext is O(1).
+    void Refill();
+    // Spread `events` over a new lowest rung starting at `start`.
+    void AddRung(uint64_t start, uint64_t span, std::vector<Event>& events);
+    // Sorted insert; an overgrown Bottom moves to a new lowest rung.
+    void InsertBottom(const Event& ev);
+
+    std::vector<Event> m_top;
+    uint64_t m_topStart = 0; // events at or after this go to Top
+    uint64_t m_topMin = UINT64_MAX;
+    uint64_t m_topMax = 0;
+    std::vector<Rung> m_rungs; // coarsest first
+    std::vector<Event> m_bottom; // ascending from m_head
+    size_t m_head = 0;
+};
+
+#endif // LADDER_SCHEDULER_H
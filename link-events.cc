@@ -0,0 +1,333 @@
+#include "link-events.h"
+
+#include "sim-probes.h"
+
+#include "ns3/point-to-point-module.h"
+
+#include <chrono>
+#include <fstream>
+#include <queue>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("LinkEvents");
+
+LinkEventManager::LinkEventManager(const NodeContainer& nodes,
+                                   const std::vector<LinkSpec>& links,
+                                   const std::vector<NetDeviceContainer>& devs)
+    : m_nodes(nodes),
+      m_links(links),
+      m_devs(devs),
+      m_up(links.size(), true),
+      m_addr(nodes.GetN()),
+      m_adj(nodes.GetN())
+{
+    for (uint32_t k = 0; k < links.size(); ++k)
+    {
+        m_adj[links[k].src].push_back(2 * k);
+        m_adj[links[k].dst].push_back(2 * k + 1);
+        for (uint32_t side = 0; side < 2; ++side)
+        {
+            Ptr<RateErrorModel> em = CreateObject<RateErrorModel>();
+            em->SetUnit(RateErrorModel::ERROR_UNIT_PACKET);
+            em->SetRate(1.0);
+            em->Disable();
+            m_devs[k].Get(side)->SetAttribute("ReceiveErrorModel", PointerValue(em));
+            m_drop.push_back(em);
+            m_devLink[m_devs[k].Get(side)] = 2 * k + side;
+        }
+    }
+
+    // Flows and routing.json address a node by its first interface
+    for (uint32_t n = 0; n < nodes.GetN(); ++n)
+    {
+        Ptr<Ipv4> ipv4 = nodes.Get(n)->GetObject<Ipv4>();
+        if (ipv4->GetNInterfaces() > 1)
+            m_addr[n] = ipv4->GetAddress(1, 0).GetLocal();
+    }
+}
+
+void
+LinkEventManager::Schedule(const std::vector<LinkEvent>& events)
+{
+    for (auto& ev : events)
+    {
+        Simulator::Schedule(Seconds(ev.time), &LinkEventManager::Apply, this, ev);
+    }
+}
+
+void
+LinkEventManager::SetVerbose(bool verbose)
+{
+    m_verbose = verbose;
+}
+
+void
+LinkEventManager::SetRouteLog(RouteLog* log)
+{
+    m_routeLog = log;
+}
+
+void
+LinkEventManager::SetLinkState(uint32_t link, bool up)
+{
+    m_up[link] = up;
+    for (uint32_t side = 0; side < 2; ++side)
+    {
+        if (up)
+            m_drop[2 * link + side]->Disable();
+        else
+            m_drop[2 * link + side]->Enable();
+    }
+}
+
+int64_t
+LinkEventManager::CurrentHop(uint32_t x, uint32_t dst) const
+{
+    Ptr<Ipv4> ipv4 = m_nodes.Get(x)->GetObject<Ipv4>();
+    Ipv4Header header;
+    header.SetDestination(m_addr[dst]);
+    Socket::SocketErrno err;
+    Ptr<Ipv4Route> route = ipv4->GetRoutingProtocol()->RouteOutput(nullptr, header, nullptr, err);
+    if (!route)
+        return -1;
+    auto it = m_devLink.find(route->GetOutputDevice());
+    return it == m_devLink.end() ? -1 : int64_t(it->second);
+}
+
+bool
+LinkEventManager::TreeCrossesDownLink(uint32_t dst) const
+{
+    for (uint32_t k = 0; k < m_links.size(); ++k)
+    {
+        if (m_up[k])
+            continue;
+        if (CurrentHop(m_links[k].src, dst) == 2 * k ||
+            CurrentHop(m_links[k].dst, dst) == 2 * k + 1)
+            return true;
+    }
+    return false;
+}
+
+std::vector<bool>
+LinkEventManager::BrokenChains(uint32_t dst) const
+{
+    enum State : uint8_t
+    {
+        UNKNOWN,
+        VISITING,
+        INTACT,
+        BROKEN
+    };
+
+    uint32_t n = m_nodes.GetN();
+    std::vector<State> state(n, UNKNOWN);
+    state[dst] = INTACT;
+    std::vector<uint32_t> chain;
+    for (uint32_t x = 0; x < n; ++x)
+    {
+        // Walk until a node with a known state, then label the walk with it.
+        // Chains that end without a route or in a loop are not the failure's
+        // doing and are left alone.
+        uint32_t v = x;
+        State end = INTACT;
+        while (state[v] == UNKNOWN)
+        {
+            state[v] = VISITING;
+            chain.push_back(v);
+            int64_t hop = CurrentHop(v, dst);
+            if (hop < 0)
+                break;
+            uint32_t k = hop / 2;
+            if (!m_up[k])
+            {
+                end = BROKEN;
+                break;
+            }
+            v = (hop % 2 == 0) ? m_links[k].dst : m_links[k].src;
+        }
+        if (state[v] == BROKEN)
+            end = BROKEN;
+        for (uint32_t c : chain)
+            state[c] = end;
+        chain.clear();
+    }
+
+    std::vector<bool> broken(n);
+    for (uint32_t x = 0; x < n; ++x)
+        broken[x] = state[x] == BROKEN;
+    return broken;
+}
+
+uint32_t
+LinkEventManager::ClearRepairs(uint32_t dst)
+{
+    auto it = m_repairs.find(dst);
+    if (it == m_repairs.end())
+        return 0;
+
+    Ipv4StaticRoutingHelper helper;
+    uint32_t removed = 0;
+    for (auto& r : it->second)
+    {
+        Ptr<Ipv4StaticRouting> sr = helper.GetStaticRouting(m_nodes.Get(r.node)->GetObject<Ipv4>());
+        for (uint32_t i = sr->GetNRoutes(); i-- > 0;)
+        {
+            Ipv4RoutingTableEntry e = sr->GetRoute(i);
+            if (e.IsHost() && e.GetDest() == m_addr[dst] && e.GetGateway() == r.gateway &&
+                e.GetInterface() == r.iface)
+            {
+                sr->RemoveRoute(i);
+                removed++;
+                SIM_PROBE5(route_del,
+                           r.node,
+                           m_addr[dst].Get(),
+                           r.gateway.Get(),
+                           r.iface,
+                           "restore");
+                if (m_routeLog)
+                    m_routeLog->Removed(r.node, m_addr[dst], r.gateway, r.iface, "restore");
+                break;
+            }
+        }
+    }
+    m_repairs.erase(it);
+    return removed;
+}
+
+uint32_t
+LinkEventManager::RepairDestination(uint32_t dst)
+{
+    // Hop-count BFS towards dst over links that are up; towards[x] is the
+    // directed link x should use.
+    std::vector<int64_t> towards(m_nodes.GetN(), -1);
+    std::vector<bool> seen(m_nodes.GetN(), false);
+    std::queue<uint32_t> q;
+    q.push(dst);
+    seen[dst] = true;
+    while (!q.empty())
+    {
+        uint32_t v = q.front();
+        q.pop();
+        for (uint32_t out : m_adj[v])
+        {
+            uint32_t k = out / 2;
+            if (!m_up[k])
+                continue;
+            uint32_t u = (out % 2 == 0) ? m_links[k].dst : m_links[k].src;
+            if (seen[u])
+                continue;
+            seen[u] = true;
+            towards[u] = out ^ 1; // u -> v is the reverse direction
+            q.push(u);
+        }
+    }
+
+    // Nodes whose chain survives keep it, even where it is longer than the
+    // BFS; a repaired node either follows the BFS or joins such a chain, so
+    // the result is loop-free.
+    std::vector<bool> broken = BrokenChains(dst);
+    Ipv4StaticRoutingHelper helper;
+    uint32_t changed = 0;
+    for (uint32_t x = 0; x < m_nodes.GetN(); ++x)
+    {
+        if (!broken[x] || towards[x] < 0 || CurrentHop(x, dst) == towards[x])
+            continue;
+
+        uint32_t k = towards[x] / 2;
+        uint32_t side = towards[x] % 2;
+        Ptr<NetDevice> local = m_devs[k].Get(side);
+        Ptr<NetDevice> remote = m_devs[k].Get(1 - side);
+        Ptr<Ipv4> ipv4 = m_nodes.Get(x)->GetObject<Ipv4>();
+        Ptr<Ipv4> peer = remote->GetNode()->GetObject<Ipv4>();
+
+        RepairRoute r;
+        r.node = x;
+        r.iface = ipv4->GetInterfaceForDevice(local);
+        r.gateway = peer->GetAddress(peer->GetInterfaceForDevice(remote), 0).GetLocal();
+
+        // Equal-metric host routes: the one added last wins the lookup
+        helper.GetStaticRouting(ipv4)->AddHostRouteTo(m_addr[dst], r.gateway, r.iface, 0);
+        m_repairs[dst].push_back(r);
+        SIM_PROBE5(route_add, x, m_addr[dst].Get(), r.gateway.Get(), r.iface, "repair");
+        if (m_routeLog)
+            m_routeLog->Added(x, m_addr[dst], r.gateway, r.iface, "repair");
+        changed++;
+    }
+    return changed;
+}
+
+void
+LinkEventManager::Apply(LinkEvent ev)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    const LinkSpec& lk = m_links[ev.link];
+    uint32_t trees = 0;
+    uint32_t changed = 0;
+
+    if (ev.type == "capacity")
+    {
+        for (uint32_t side = 0; side < 2; ++side)
+            m_devs[ev.link].Get(side)->SetAttribute("DataRate", StringValue(ev.bw));
+    }
+    else if (ev.type == "link_down" && m_up[ev.link])
+    {
+        // Find the trees that cross the link before it disappears
+        std::vector<uint32_t> affected;
+        for (uint32_t d = 0; d < m_nodes.GetN(); ++d)
+        {
+            if (m_addr[d] == Ipv4Address())
+                continue; // node without links
+            if (CurrentHop(lk.src, d) == 2 * ev.link || CurrentHop(lk.dst, d) == 2 * ev.link + 1)
+                affected.push_back(d);
+        }
+        SetLinkState(ev.link, false);
+        for (uint32_t d : affected)
+        {
+            changed += RepairDestination(d);
+            trees++;
+        }
+    }
+    else if (ev.type == "link_up" && !m_up[ev.link])
+    {
+        SetLinkState(ev.link, true);
+        // Only repaired destinations can benefit; drop their overrides and
+        // keep the original routes unless they still cross a failed link.
+        std::vector<uint32_t> repaired;
+        for (auto& kv : m_repairs)
+            repaired.push_back(kv.first);
+        for (uint32_t d : repaired)
+        {
+            changed += ClearRepairs(d);
+            if (TreeCrossesDownLink(d))
+                changed += RepairDestination(d);
+            trees++;
+        }
+    }
+
+    double us =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    if (m_verbose)
+    {
+        NS_LOG_UNCOND("[EVENT] t=" << Simulator::Now().GetSeconds() << "s " << ev.type << " link "
+                                   << lk.src << "-" << lk.dst << ": " << trees << " tree(s), "
+                                   << changed << " route change(s) in " << us << " us");
+    }
+    m_log.push_back({Simulator::Now().GetSeconds(), ev, trees, changed, us});
+}
+
+void
+LinkEventManager::WriteLog(const std::string& file) const
+{
+    if (m_log.empty())
+        return;
+    std::ofstream out(file);
+    out << "time_s,type,link,src_idx,dst_idx,bandwidth,trees_recomputed,routes_changed,repair_us\n";
+    for (auto& e : m_log)
+    {
+        const LinkSpec& lk = m_links[e.event.link];
+        out << e.time << "," << e.event.type << "," << e.event.link << "," << lk.src << ","
+            << lk.dst << "," << e.event.bw << "," << e.treesRecomputed << "," << e.routesChanged
+            << "," << e.repairUs << "\n";
+    }
+}
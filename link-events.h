@@ -0,0 +1,87 @@
+#ifndef LINK_EVENTS_H
+#define LINK_EVENTS_H
+
+#include "route-log.h"
+#include "topology-spec.h"
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Applies topology.json link events during the run and repairs routing
+// incrementally. A failed link drops everything it receives (both devices get
+// an enabled error model) while the IP interfaces stay up, so the routes
+// installed at setup survive until the link recovers.
+//
+// Forwarding is destination based, so a destination's tree crosses link u-v
+// iff u routes to it via v or v via u. On a change only those destinations are
+// repaired, and only at the nodes whose forwarding chain towards them crosses
+// a failed link: each gets a static host route to its next hop on a hop-count
+// BFS over the links that are up. Every other node keeps its route, including
+// deliberately longer routing.json paths, and so does global routing.
+class LinkEventManager
+{
+  public:
+    LinkEventManager(const ns3::NodeContainer& nodes,
+                     const std::vector<LinkSpec>& links,
+                     const std::vector<ns3::NetDeviceContainer>& devs);
+
+    void Schedule(const std::vector<LinkEvent>& events);
+
+    // Log each applied event (default on).
+    void SetVerbose(bool verbose);
+
+    // Report repair routes added and removed to `log` (null = none).
+    void SetRouteLog(RouteLog* log);
+
+    // One row per applied event: what changed and what the repair cost.
+    void WriteLog(const std::string& file) const;
+
+  private:
+    struct RepairRoute
+    {
+        uint32_t node;
+        ns3::Ipv4Address gateway;
+        uint32_t iface;
+    };
+
+    struct LogEntry
+    {
+        double time;
+        LinkEvent event;
+        uint32_t treesRecomputed;
+        uint32_t routesChanged;
+        double repairUs; // wall-clock repair cost
+    };
+
+    void Apply(LinkEvent ev);
+    void SetLinkState(uint32_t link, bool up);
+    // Directed link (2k: src->dst, 2k+1: dst->src) node `x` uses towards `dst`,
+    // or -1 if it has no route or the route leaves through a non-topology device.
+    int64_t CurrentHop(uint32_t x, uint32_t dst) const;
+    bool TreeCrossesDownLink(uint32_t dst) const;
+    // Per node, whether following current routes towards `dst` crosses a
+    // failed link.
+    std::vector<bool> BrokenChains(uint32_t dst) const;
+    uint32_t RepairDestination(uint32_t dst);
+    uint32_t ClearRepairs(uint32_t dst);
+
+    ns3::NodeContainer m_nodes;
+    std::vector<LinkSpec> m_links;
+    std::vector<ns3::NetDeviceContainer> m_devs;
+    std::vector<bool> m_up;
+    std::vector<ns3::Ptr<ns3::RateErrorModel>> m_drop; // two per link
+    std::vector<ns3::Ipv4Address> m_addr;              // traffic address of each node
+    std::vector<std::vector<uint32_t>> m_adj;          // node -> outgoing directed links
+    std::map<ns3::Ptr<ns3::NetDevice>, uint32_t> m_devLink; // device -> directed link
+    std::map<uint32_t, std::vector<RepairRoute>> m_repairs;
+    std::vector<LogEntry> m_log;
+    bool m_verbose = true;
+    RouteLog* m_routeLog = nullptr;
+};
+
+#endif // LINK_EVENTS_H
@@ -0,0 +1,102 @@
+#include "link-queues.h"
+
+#include "ns3/core-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("LinkQueues");
+
+bool
+LinkQueue::IsAqm() const
+{
+    return type != "DropTail";
+}
+
+double
+LinkQueue::SaturatedPackets(double bps, uint32_t pktBytes) const
+{
+    double packets = size.GetUnit() == QueueSizeUnit::PACKETS
+                         ? double(size.GetValue())
+                         : double(size.GetValue()) / pktBytes;
+    if (type == "RED")
+        return 0.4 * packets; // midway between MinTh and MaxTh below
+    if (type == "CoDel" || type == "FqCoDel")
+        return std::min(packets, 0.005 * bps / (pktBytes * 8.0));
+    return packets;
+}
+
+LinkQueue
+ResolveLinkQueue(const LinkSpec& lk, const QueueDefaults& defaults)
+{
+    LinkQueue q;
+    q.type = !defaults.type.empty() ? defaults.type : lk.queueType;
+    if (q.type.empty())
+        q.type = "DropTail";
+    // LoadTopology and the command line reject unknown types
+    NS_ABORT_MSG_UNLESS(IsQueueType(q.type),
+                        "Unknown queue type " << q.type << " on link " << lk.src << "-"
+                                              << lk.dst);
+
+    std::string size = !defaults.size.empty() ? defaults.size : lk.queueSize;
+    if (!size.empty())
+    {
+        q.size = QueueSize(size);
+        return q;
+    }
+
+    double bdpBytes = DataRate(lk.bw).GetBitRate() * defaults.bdpRtt / 8.0 * defaults.bdpScale;
+    uint32_t bytes = std::max<uint32_t>(std::ceil(bdpBytes), defaults.minBytes);
+    q.size = QueueSize(QueueSizeUnit::BYTES, bytes);
+    return q;
+}
+
+void
+PrepareDeviceQueue(PointToPointHelper& p2p, const LinkQueue& q)
+{
+    // With an AQM the device keeps a single packet so the queue builds up
+    // where the AQM can see it.
+    p2p.SetQueue("ns3::DropTailQueue",
+                 "MaxSize",
+                 QueueSizeValue(q.IsAqm() ? QueueSize("1p") : q.size));
+}
+
+void
+InstallQueueDisc(const NetDeviceContainer& devs, const LinkQueue& q)
+{
+    if (!q.IsAqm())
+        return;
+
+    TrafficControlHelper tch;
+    if (q.type == "RED")
+    {
+        // RED runs in packet mode; its thresholds follow the limit.
+        uint32_t limit = q.size.GetUnit() == QueueSizeUnit::PACKETS
+                             ? q.size.GetValue()
+                             : std::max<uint32_t>(q.size.GetValue() / 512, 3);
+        tch.SetRootQueueDisc("ns3::RedQueueDisc",
+                             "MaxSize",
+                             QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, limit)),
+                             "MinTh",
+                             DoubleValue(std::max(1.0, 0.2 * limit)),
+                             "MaxTh",
+                             DoubleValue(std::max(2.0, 0.6 * limit)));
+    }
+    else
+    {
+        tch.SetRootQueueDisc("ns3::" + q.type + "QueueDisc", "MaxSize", QueueSizeValue(q.size));
+    }
+    tch.Install(devs);
+}
+
+void
+FinishLinkQueue(const NetDeviceContainer& devs, const LinkQueue& q)
+{
+    if (q.IsAqm())
+        return;
+    TrafficControlHelper tch;
+    tch.Uninstall(devs);
+}
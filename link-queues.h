@@ -0,0 +1,48 @@
+#ifndef LINK_QUEUES_H
+#define LINK_QUEUES_H
+
+#include "topology-spec.h"
+
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <string>
+
+// Buffer sizing defaults for links that do not set "queue_size".
+struct QueueDefaults
+{
+    double bdpRtt = 0.02;     // reference RTT for the C x RTT rule (s)
+    double bdpScale = 1.0;    // multiplier for buffer-size sweeps
+    std::string size;         // forces this size on every link if set
+    std::string type;         // forces this queue type on every link if set
+    uint32_t minBytes = 1500; // never size a buffer below one MTU
+};
+
+// Resolved queue configuration of one link (both directions).
+struct LinkQueue
+{
+    std::string type; // DropTail, RED, CoDel or FqCoDel
+    ns3::QueueSize size;
+
+    bool IsAqm() const;
+    // Steady-state occupancy of a saturated queue in `pktBytes` packets, used
+    // by the fluid engine: a full DropTail buffer, RED's mean threshold, or
+    // CoDel's 5 ms target.
+    double SaturatedPackets(double bps, uint32_t pktBytes) const;
+};
+
+// Per-link setting, then the global override, then bandwidth x bdpRtt.
+LinkQueue ResolveLinkQueue(const LinkSpec& lk, const QueueDefaults& defaults);
+
+// Configure the device queue on `p2p` before installing the link.
+void PrepareDeviceQueue(ns3::PointToPointHelper& p2p, const LinkQueue& q);
+
+// Install the AQM root queue disc right after the devices are created, so that
+// address assignment does not add its default FqCoDel.
+void InstallQueueDisc(const ns3::NetDeviceContainer& devs, const LinkQueue& q);
+
+// After address assignment: plain DropTail links drop the default queue disc
+// so the device buffer is the only one.
+void FinishLinkQueue(const ns3::NetDeviceContainer& devs, const LinkQueue& q);
+
+#endif // LINK_QUEUES_H
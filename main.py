@@ -17,6 +17,11 @@ import shutil
 from datetime import datetime
 from pathlib import Path
 
+try:
+    import ns3sim  # in-process simulator, see python/setup.py
+except ImportError:
+    ns3sim = None
+
 # Configuration
 NS3_BINARY = "/Users/dheerajmurthy/Downloads/IIITB/sem6/NHPC/project/simulation/ns-allinone-3.42/ns-3.42/ns3"
 PROJECT_DIR = "scratch/my_project"
@@ -91,6 +96,9 @@ def run_ns3_simulation(model_name, model_dir):
         shutil.copy2(current_routing, model_routing)
         print(f"Copied routing.json to {model_routing}")
     
+    if ns3sim is not None:
+        return run_ns3_in_process(model_name, model_dir, model_routing)
+    
     # ns-3 command
     ns3_cmd = [
         NS3_BINARY,
@@ -101,7 +109,8 @@ def run_ns3_simulation(model_name, model_dir):
         f"--routes={model_routing}",
         f"--metrics={PROJECT_DIR}/metrics.csv",
         f"--anim={PROJECT_DIR}/sim-anim.xml",
-        f"--flows=30"
+        f"--flows=30",
+        "--crn=1"
     ]
     
     try:
@@ -134,6 +143,31 @@ def run_ns3_simulation(model_name, model_dir):
         print(f"Exception running ns-3 simulation for {model_name}: {e}")
         return False
 
+def run_ns3_in_process(model_name, model_dir, model_routing):
+    """Run the simulation through the ns3sim bindings, writing straight into model_dir."""
+    scenario = ns3sim.Scenario()
+    try:
+        scenario.load(f"{FULL_PROJECT_PATH}/topology.json", str(model_routing))
+    except RuntimeError as e:
+        print(f"Error loading scenario for {model_name}: {e}")
+        return False
+    
+    cfg = scenario.config
+    cfg.flows = 30
+    cfg.crn = True
+    cfg.metrics = str(model_dir / "metrics.csv")
+    cfg.anim = True
+    cfg.anim_file = str(model_dir / "sim-anim.xml")
+    
+    if scenario.run() != 0:
+        print(f"Error running in-process simulation for {model_name}")
+        return False
+    
+    summary = scenario.summary()
+    print(f"✓ {model_name} simulation completed in-process "
+          f"({summary['flows']} flows, {summary['throughput_mbps']:.2f} Mbps)")
+    return True
+
 def analyze_model_metrics_basic(model_name, model_dir):
     """Basic metrics analysis without pandas."""
     metrics_file = model_dir / "metrics.csv"
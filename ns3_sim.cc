@@ -1,76 +1,555 @@
-#include "ns3/applications-module.h"
+#include "convergence-monitor.h"
+#include "env-pool.h"
+#include "fork-pool.h"
+#include "scenario.h"
+#include "sched-bench.h"
+#include "sim-trace.h"
+
 #include "ns3/core-module.h"
-#include "ns3/flow-monitor-module.h"
-#include "ns3/internet-module.h"
-#include "ns3/mobility-module.h"
-#include "ns3/netanim-module.h"
-#include "ns3/network-module.h"
-#include "ns3/point-to-point-module.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <map>
-#include <nlohmann/json.hpp>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
 
-using json = nlohmann::json;
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("Ns3SimJson");
 
-struct LinkSpec
+// Insert "-run<N>" before the extension: metrics.csv -> metrics-run3.csv
+static std::string
+RunSuffixedName(const std::string& file, uint64_t run)
+{
+    std::string::size_type slash = file.find_last_of('/');
+    std::string::size_type dot = file.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+        dot = file.size();
+    }
+    std::ostringstream oss;
+    oss << file.substr(0, dot) << "-run" << run << file.substr(dot);
+    return oss.str();
+}
+
+// Fork one child per RNG run after setup. Children share the built topology
+// copy-on-write, install their own traffic and write run-suffixed outputs.
+static int
+RunForkedSeeds(SimTopology& sim, const RunConfig& cfg, uint32_t nSeeds, uint32_t maxJobs)
+{
+    uint64_t baseRun = RngSeedManager::GetRun();
+    ForkPool pool(maxJobs);
+
+    NS_LOG_UNCOND("[FORK] Setup done, running " << nSeeds << " seeds (runs " << baseRun << ".."
+                                                << baseRun + nSeeds - 1 << ", "
+                                                << pool.GetMaxJobs() << " at a time)");
+
+    auto work = [&](uint32_t i, std::ostream&) {
+        uint64_t run = baseRun + i;
+        RngSeedManager::SetRun(run);
+        srand(static_cast<unsigned>(run));
+        RunConfig runCfg = cfg;
+        runCfg.metricsFile = RunSuffixedName(cfg.metricsFile, run);
+        runCfg.animFile = RunSuffixedName(cfg.animFile, run);
+        runCfg.routesFile = RunSuffixedName(cfg.routesFile, run);
+        runCfg.flowmonFile = RunSuffixedName(cfg.flowmonFile, run);
+        runCfg.windowsFile = RunSuffixedName(cfg.windowsFile, run);
+        runCfg.eventsFile = RunSuffixedName(cfg.eventsFile, run);
+        runCfg.pathsFile = RunSuffixedName(cfg.pathsFile, run);
+        runCfg.pathReportFile = RunSuffixedName(cfg.pathReportFile, run);
+        runCfg.dropsFile = RunSuffixedName(cfg.dropsFile, run);
+        if (!cfg.routeLogFile.empty())
+            runCfg.routeLogFile = RunSuffixedName(cfg.routeLogFile, run);
+        return RunTraffic(sim, runCfg);
+    };
+    uint32_t failures = pool.Run(0, nSeeds, work, [](uint32_t, bool, const std::string&) {});
+
+    NS_LOG_UNCOND("[FORK] " << nSeeds - failures << "/" << nSeeds << " seeds completed");
+    return failures == 0 ? 0 : 1;
+}
+
+// Sequential replication: launch rounds of forked seeds (RngRun, RngRun+1, ...)
+// until the 95% CI half-width of aggregate throughput, p99 delay and loss is
+// within `relWidth` of each mean, or `maxReps` replications have run.
+static int
+RunReplications(SimTopology& sim,
+                const RunConfig& cfg,
+                uint32_t maxReps,
+                uint32_t minReps,
+                double relWidth,
+                uint32_t maxJobs,
+                const std::string& outFile)
 {
-    uint32_t src;
-    uint32_t dst;
-    std::string bw;
-    std::string delay;
-};
+    uint64_t baseRun = RngSeedManager::GetRun();
+    ForkPool pool(maxJobs);
+    NS_LOG_UNCOND("[REPLICATE] Up to " << maxReps << " runs from RngRun " << baseRun
+                                       << ", target CI +/-" << relWidth * 100 << "%, "
+                                       << pool.GetMaxJobs() << " workers");
+
+    RunConfig repCfg = cfg;
+    repCfg.DisableFileOutput();
+    if (sim.linkEvents)
+        sim.linkEvents->SetVerbose(false);
+
+    auto work = [&](uint32_t i, std::ostream& out) {
+        uint64_t run = baseRun + i;
+        RngSeedManager::SetRun(run);
+        srand(static_cast<unsigned>(run));
+        RunSummary summary;
+        int rc = RunTraffic(sim, repCfg, &summary);
+        out << summary.flows << "," << summary.throughputMbps << "," << summary.P99DelayMs()
+            << "," << summary.LossPct();
+        return rc;
+    };
+
+    const char* names[] = {"agg_throughput_mbps", "p99_delay_ms", "loss_pct"};
+    std::vector<double> samples[3];
+    double mean[3] = {0.0, 0.0, 0.0};
+    double hw[3] = {INFINITY, INFINITY, INFINITY};
+    std::ofstream out(outFile);
+    out << "run,flows," << names[0] << "," << names[1] << "," << names[2] << "\n";
+
+    uint32_t launched = 0;
+    bool converged = false;
+    while (!converged && launched < maxReps)
+    {
+        uint32_t round = std::max(pool.GetMaxJobs(), minReps > launched ? minReps - launched : 0);
+        round = std::min(round, maxReps - launched);
+        std::vector<std::string> rows(round);
+        pool.Run(launched, round, work, [&](uint32_t i, bool ok, const std::string& output) {
+            rows[i - launched] = ok ? output : "";
+        });
+
+        // Append in run order so the estimates do not depend on completion order
+        for (uint32_t i = 0; i < round; ++i)
+        {
+            if (rows[i].empty())
+                continue;
+            out << baseRun + launched + i << "," << rows[i] << "\n";
+            std::istringstream iss(rows[i]);
+            std::string field;
+            std::getline(iss, field, ',');
+            for (int m = 0; m < 3 && std::getline(iss, field, ','); ++m)
+                samples[m].push_back(std::stod(field));
+        }
+        launched += round;
+
+        uint32_t n = samples[0].size();
+        converged = n >= std::max(minReps, 2u);
+        for (int m = 0; m < 3; ++m)
+        {
+            BatchMeansInterval(samples[m], 0, mean[m], hw[m]);
+            // p99 is NaN when --warmup/--window suppress the delay histograms
+            if (!std::isnan(mean[m]) && !(hw[m] <= relWidth * std::fabs(mean[m])))
+                converged = false;
+        }
+        NS_LOG_UNCOND("[REPLICATE] " << n << " runs: " << std::fixed << std::setprecision(3)
+                                     << mean[0] << " +/- " << hw[0] << " Mbps, p99 " << mean[1]
+                                     << " +/- " << hw[1] << " ms, loss " << mean[2] << " +/- "
+                                     << hw[2] << " %");
+    }
+    out.close();
+
+    NS_LOG_UNCOND("[REPLICATE] " << (converged ? "Converged" : "Stopped at the cap") << " after "
+                                 << samples[0].size() << " replications → " << outFile);
+    return 0;
+}
+
+// N-k resilience sweep. Scenario 0 is the intact topology, then one scenario
+// per combination of k links failed from t=0. Scenarios run in forked workers
+// that share the built topology and use the same RNG run, so they differ only
+// in the failed links; the parent writes one summary row per scenario.
+static int
+RunResilienceSweep(SimTopology& sim,
+                   const std::vector<LinkSpec>& links,
+                   const RunConfig& cfg,
+                   uint32_t k,
+                   uint32_t maxJobs,
+                   const std::string& outFile)
+{
+    std::vector<std::vector<uint32_t>> scenarios{{}};
+    std::vector<uint32_t> combo(k);
+    for (uint32_t i = 0; i < k; ++i)
+        combo[i] = i;
+    while (k > 0 && k <= links.size())
+    {
+        scenarios.push_back(combo);
+        // Next k-combination in lexicographic order
+        int32_t i = k - 1;
+        while (i >= 0 && combo[i] == links.size() - k + i)
+            i--;
+        if (i < 0)
+            break;
+        combo[i]++;
+        for (uint32_t j = i + 1; j < k; ++j)
+            combo[j] = combo[j - 1] + 1;
+    }
+
+    ForkPool pool(maxJobs);
+    NS_LOG_UNCOND("[SWEEP] N-" << k << ": " << scenarios.size() << " scenarios, "
+                               << pool.GetMaxJobs() << " workers");
+
+    sim.linkEvents->SetVerbose(false);
+    RunConfig scenarioCfg = cfg;
+    scenarioCfg.DisableFileOutput();
+
+    auto work = [&](uint32_t s, std::ostream& out) {
+        std::vector<LinkEvent> failures;
+        for (uint32_t link : scenarios[s])
+            failures.push_back(LinkEvent{0.0, "link_down", link, ""});
+        sim.linkEvents->Schedule(failures);
+
+        RunSummary summary;
+        int rc = RunTraffic(sim, scenarioCfg, &summary);
+        out << summary.flows << "," << summary.throughputMbps << "," << summary.LossPct() << ","
+            << summary.worstThroughput << "," << summary.worstSrc << "," << summary.worstDst;
+        return rc;
+    };
+    std::vector<std::string> rows(scenarios.size());
+    uint32_t done = 0;
+    auto collect = [&](uint32_t s, bool ok, const std::string& output) {
+        rows[s] = ok ? output : "";
+        if (++done % 100 == 0)
+            NS_LOG_UNCOND("[SWEEP] " << done << "/" << scenarios.size());
+    };
+    uint32_t failed = pool.Run(0, scenarios.size(), work, collect);
+
+    std::ofstream out(outFile);
+    out << "scenario,failed_links,flows,agg_throughput_mbps,loss_pct,worst_flow_mbps,worst_src,"
+           "worst_dst\n";
+    for (uint32_t s = 0; s < scenarios.size(); ++s)
+    {
+        if (rows[s].empty())
+            continue;
+        out << s << ",";
+        for (size_t i = 0; i < scenarios[s].size(); ++i)
+        {
+            const LinkSpec& lk = links[scenarios[s][i]];
+            out << (i ? ";" : "") << lk.src << "-" << lk.dst;
+        }
+        out << (scenarios[s].empty() ? "none," : ",") << rows[s] << "\n";
+    }
+    out.close();
+
+    NS_LOG_UNCOND("[SWEEP] " << scenarios.size() - failed << "/" << scenarios.size()
+                             << " scenarios → " << outFile);
+    return failed == 0 ? 0 : 1;
+}
+
+// Offered-load sweep: one run per scale factor on every flow's rate, all with
+// the same RNG run so the points differ only in load. Packet runs fork from
+// one built topology; fluid runs are cheap enough to solve in turn.
+static int
+RunLoadSweep(Scenario& scenario,
+             const std::vector<double>& scales,
+             uint32_t maxJobs,
+             const std::string& outFile)
+{
+    RunConfig sweepCfg = scenario.Config();
+    sweepCfg.DisableFileOutput();
+
+    auto format = [](const RunSummary& s) {
+        std::ostringstream oss;
+        oss << s.flows << "," << s.offeredMbps << "," << s.throughputMbps << "," << s.LossPct()
+            << "," << s.P99DelayMs();
+        return oss.str();
+    };
+    std::vector<std::string> rows(scales.size());
+    uint32_t failed = 0;
+    if (sweepCfg.mode == "fluid")
+    {
+        NS_LOG_UNCOND("[LOAD] " << scales.size() << " load scales, fluid model");
+        for (size_t i = 0; i < scales.size(); ++i)
+        {
+            RunConfig& cfg = scenario.Config();
+            cfg = sweepCfg;
+            cfg.loadScale = scales[i];
+            if (scenario.Run() != 0)
+            {
+                failed++;
+                continue;
+            }
+            rows[i] = format(scenario.GetSummary());
+        }
+    }
+    else
+    {
+        scenario.Build();
+        SimTopology& sim = scenario.GetTopology();
+        ForkPool pool(maxJobs);
+        NS_LOG_UNCOND("[LOAD] " << scales.size() << " load scales, " << pool.GetMaxJobs()
+                                << " workers");
+        auto work = [&](uint32_t i, std::ostream& out) {
+            RunConfig cfg = sweepCfg;
+            cfg.loadScale = scales[i];
+            RunSummary summary;
+            int rc = RunTraffic(sim, cfg, &summary);
+            out << format(summary);
+            return rc;
+        };
+        auto collect = [&](uint32_t i, bool ok, const std::string& output) {
+            rows[i] = ok ? output : "";
+        };
+        failed = pool.Run(0, scales.size(), work, collect);
+        Simulator::Destroy();
+    }
+
+    std::ofstream out(outFile);
+    out << "load_scale,flows,offered_mbps,agg_throughput_mbps,loss_pct,p99_delay_ms\n";
+    for (size_t i = 0; i < scales.size(); ++i)
+    {
+        if (!rows[i].empty())
+            out << scales[i] << "," << rows[i] << "\n";
+    }
+    out.close();
+
+    NS_LOG_UNCOND("[LOAD] " << scales.size() - failed << "/" << scales.size() << " load points → "
+                            << outFile);
+    return failed == 0 ? 0 : 1;
+}
 
 int
 main(int argc, char* argv[])
 {
     CommandLine cmd;
     std::string topoFile = "topology.json";
-    std::string routeFile = "routing.json";
+    std::string routeFile;
+    std::string gen;
+    ImportOptions importOpts;
     std::string animFile = "sim-anim.xml";
     std::string metricsFile = "metrics.csv";
     uint32_t nFlows = 50;
     bool fastMode = false;
+    uint32_t forkSeeds = 0;
+    uint32_t forkJobs = 0;
+    double maxTime = 0.0;
+    bool autoStop = false;
+    ConvergenceMonitor::Params convergence;
+    double warmup = 0.0;
+    double windowInterval = 0.0;
+    std::string windowsFile = "windows.csv";
+    std::string mode = "packet";
+    std::string routing = "static";
+    bool lean = false;
+    uint32_t trainLength = 1;
+    QueueDefaults queues;
+    std::string eventsFile = "link-events.csv";
+    uint32_t resilience = 0;
+    std::string sweepFile = "resilience.csv";
+    bool crn = false;
+    uint32_t replicate = 0;
+    uint32_t repMin = 3;
+    double repWidth = 0.05;
+    std::string replicateFile = "replications.csv";
+    bool useDemand = false;
+    double loadScale = 1.0;
+    std::string loadSweep;
+    std::string loadSweepFile = "load-sweep.csv";
+    uint32_t pathTrace = 0;
+    std::string pathsFile = "paths.csv";
+    std::string pathReportFile = "path-report.csv";
+    bool drops = false;
+    std::string dropsFile = "drops.csv";
+    std::string routeLogFile;
+    double routeLogStart = 0.0;
+    double routeLogStop = 0.0;
+    std::string envSocket;
+    double envStep = 0.1;
+    uint32_t envMaxActions = 1024;
+    uint32_t envPool = 0;
+    uint32_t envEpisodes = 0;
+    std::string scheduler = "map";
+    std::string schedTrace;
+    std::string schedBench;
+    std::string schedBenchFile = "sched-bench.csv";
+    std::string traceFile;
+    SimTrace::Params traceParams;
 
     cmd.AddValue("topo", "Topology JSON file", topoFile);
-    cmd.AddValue("routes", "Routing JSON file (optional)", routeFile);
+    cmd.AddValue("topoFormat",
+                 "Format of --topo: json, graphml or rocketfuel (default from the file name)",
+                 importOpts.format);
+    cmd.AddValue("importBw", "Capacity of imported links that have none", importOpts.bw);
+    cmd.AddValue("importDelay",
+                 "Delay of imported links without a latency or coordinates",
+                 importOpts.delay);
+    cmd.AddValue("routes",
+                 "Routing JSON file (default routing.json, none with --gen or an imported --topo)",
+                 routeFile);
+    cmd.AddValue("gen",
+                 "Generate the topology instead: fattree, leafspine, jellyfish, waxman, ba or "
+                 "torus, optionally :key=value,...",
+                 gen);
     cmd.AddValue("anim", "NetAnim XML output", animFile);
     cmd.AddValue("metrics", "CSV metrics output", metricsFile);
     cmd.AddValue("flows", "Number of random flows", nFlows);
     cmd.AddValue("fast", "Enable fast debug mode", fastMode);
+    cmd.AddValue("forkSeeds",
+                 "Build the topology once, then fork this many children (runs RngRun..RngRun+N-1)",
+                 forkSeeds);
+    cmd.AddValue("forkJobs", "Max concurrent fork children (0 = one per CPU)", forkJobs);
+    cmd.AddValue("maxTime", "Simulation stop time in s (0 = 42, or 12 in fast mode)", maxTime);
+    cmd.AddValue("autoStop", "Stop early once throughput and delay reach steady state", autoStop);
+    cmd.AddValue("batchInterval", "Steady-state batch length in seconds", convergence.interval);
+    cmd.AddValue("ciWidth", "Target relative CI half-width for auto stop", convergence.relWidth);
+    cmd.AddValue("minBatches", "Batches required after MSER truncation", convergence.minBatches);
+    cmd.AddValue("warmup", "Exclude flow statistics before this time (s)", warmup);
+    cmd.AddValue("window", "Measurement window length for the per-window table (s)",
+                 windowInterval);
+    cmd.AddValue("windowsOut", "Per-window CSV output", windowsFile);
+    cmd.AddValue("mode", "Engine: packet (ns-3) or fluid (max-min fair flow model)", mode);
+    cmd.AddValue("routing",
+                 "routing.json routes: static, flat (hashed tables) or source (path tags)",
+                 routing);
+    cmd.AddValue("lean", "Install only IPv4/UDP per node and skip unused mobility", lean);
+    cmd.AddValue("train", "Send K back-to-back packets per event at the same rate", trainLength);
+    cmd.AddValue("queueType", "Force DropTail/RED/CoDel/FqCoDel on every link", queues.type);
+    cmd.AddValue("queueSize", "Force this buffer size (e.g. 3p, 64KB) on every link", queues.size);
+    cmd.AddValue("bdpRtt", "Reference RTT (s) for bandwidth-delay buffer defaults", queues.bdpRtt);
+    cmd.AddValue("bdpScale", "Multiplier on bandwidth-delay buffer defaults", queues.bdpScale);
+    cmd.AddValue("eventsOut", "CSV log of applied link events and route repairs", eventsFile);
+    cmd.AddValue("resilience", "Sweep all k-link failure combinations (N-k), 0 = off", resilience);
+    cmd.AddValue("sweepOut", "Per-scenario resilience summary CSV", sweepFile);
+    cmd.AddValue("crn", "Common random numbers: same traffic for every routing model", crn);
+    cmd.AddValue("replicate", "Replicate seeds until the CI target is met, max runs", replicate);
+    cmd.AddValue("repMin", "Minimum replications before testing the CI target", repMin);
+    cmd.AddValue("repWidth", "Target relative 95% CI half-width across replications", repWidth);
+    cmd.AddValue("replicateOut", "Per-replication summary CSV", replicateFile);
+    cmd.AddValue("demand", "Offer each route's routing.json demand (Mbps) as its flow rate",
+                 useDemand);
+    cmd.AddValue("loadScale", "Multiply every flow's offered rate by this factor", loadScale);
+    cmd.AddValue("loadSweep", "Comma-separated load scales to run in turn (e.g. 0.5,1,2)",
+                 loadSweep);
+    cmd.AddValue("loadSweepOut", "Per-load-scale summary CSV", loadSweepFile);
+    cmd.AddValue("pathTrace", "Record the forwarding path of 1 in N packets per flow (0 = off)",
+                 pathTrace);
+    cmd.AddValue("pathsOut", "Observed path histogram CSV", pathsFile);
+    cmd.AddValue("pathReportOut", "Per-flow path mismatch and TTL expiry report", pathReportFile);
+    cmd.AddValue("drops", "Count drops by reason per link, node and flow", drops);
+    cmd.AddValue("dropsOut", "Drop counter CSV", dropsFile);
+    cmd.AddValue("routeLog",
+                 "CSV of route changes during the run (replaces NetAnim's routes.xml dumps)",
+                 routeLogFile);
+    cmd.AddValue("routeLogStart", "Log route changes from this time (s)", routeLogStart);
+    cmd.AddValue("routeLogStop", "Log route changes until this time (s, 0 = end)", routeLogStop);
+    cmd.AddValue("env", "Unix socket path for a step-wise agent (shared memory in PATH.shm)",
+                 envSocket);
+    cmd.AddValue("envStep", "Simulated seconds between agent steps", envStep);
+    cmd.AddValue("envMaxActions", "Route updates the agent may send per step", envMaxActions);
+    cmd.AddValue("envPool", "Step this many forked environments in lockstep (0 = one run)",
+                 envPool);
+    cmd.AddValue("envEpisodes", "Episodes to run across the pool (0 = one per environment)",
+                 envEpisodes);
+    cmd.AddValue("scheduler", "Event scheduler: map, heap, calendar, list or ladder", scheduler);
+    cmd.AddValue("schedTrace", "Record the run's scheduler operations to this file", schedTrace);
+    cmd.AddValue("schedBench", "Replay a --schedTrace file against every scheduler and exit",
+                 schedBench);
+    cmd.AddValue("schedBenchOut", "Per-scheduler replay timing CSV", schedBenchFile);
+    cmd.AddValue("trace", "Chrome/Perfetto trace JSON of phases, events and packets", traceFile);
+    cmd.AddValue("traceEventSample", "Time 1 in N event callbacks", traceParams.eventSample);
+    cmd.AddValue("tracePacketSample", "Follow 1 in N packets", traceParams.packetSample);
+    cmd.AddValue("traceBuffer", "Trace records kept (32 bytes each)", traceParams.capacity);
     cmd.Parse(argc, argv);
 
-    // Load topology JSON
-    json topo;
+    if (!schedBench.empty())
+    {
+        return BenchmarkSchedulers(schedBench, schedBenchFile);
+    }
+    if (SchedulerTypeName(scheduler).empty())
+    {
+        std::cerr << "Unknown scheduler: " << scheduler << "\n";
+        return 1;
+    }
+    if (!queues.type.empty() && !IsQueueType(queues.type))
+    {
+        std::cerr << "Unknown queue type: " << queues.type << "\n";
+        return 1;
+    }
+    if (!schedTrace.empty() && (mode != "packet" || forkSeeds > 0 || replicate > 0 ||
+                                resilience > 0 || !loadSweep.empty() || envPool > 0))
+    {
+        std::cerr << "--schedTrace needs a single packet-mode run\n";
+        return 1;
+    }
+    if (!traceFile.empty() && (mode != "packet" || forkSeeds > 0 || replicate > 0 ||
+                               resilience > 0 || !loadSweep.empty() || envPool > 0 ||
+                               !schedTrace.empty()))
+    {
+        std::cerr << "--trace needs a single packet-mode run without --schedTrace\n";
+        return 1;
+    }
+    std::unique_ptr<SimTrace> trace;
+    if (!traceFile.empty())
+        trace = std::make_unique<SimTrace>(traceParams);
+
+    std::vector<double> loadScales;
+    std::istringstream scaleList(loadSweep);
+    for (std::string field; std::getline(scaleList, field, ',');)
     {
-        std::ifstream in(topoFile);
-        if (!in.is_open())
+        double scale = std::atof(field.c_str());
+        if (!(scale > 0.0))
         {
-            std::cerr << "Failed to open topology file: " << topoFile << "\n";
+            std::cerr << "Invalid load scale: " << field << "\n";
             return 1;
         }
-        in >> topo;
+        loadScales.push_back(scale);
+    }
+    if (!(loadScale > 0.0))
+    {
+        std::cerr << "Invalid load scale: " << loadScale << "\n";
+        return 1;
+    }
+    double measureEnd = std::min(fastMode ? 9.0 : 38.0, maxTime > 0.0 ? maxTime : 42.0);
+    if (warmup > 0.0 && warmup >= measureEnd)
+    {
+        std::cerr << "--warmup must end before traffic stops (" << measureEnd << "s)\n";
+        return 1;
+    }
+    if (!envSocket.empty() && (mode != "packet" || forkSeeds > 0 || replicate > 0 ||
+                               resilience > 0 || !loadScales.empty() || !(envStep > 0.0)))
+    {
+        std::cerr << "--env needs a single packet-mode run and a positive --envStep\n";
+        return 1;
+    }
+    if (envPool > 0 && envSocket.empty())
+    {
+        std::cerr << "--envPool needs --env\n";
+        return 1;
+    }
+    // Source-routed packets keep their path, so they would ignore link
+    // failures, route repairs and agent actions alike
+    if (routing == "source" && (resilience > 0 || !envSocket.empty()))
+    {
+        std::cerr << "--routing=source cannot reroute; drop --resilience and --env\n";
+        return 1;
     }
 
-    uint32_t nNodes = topo.value("nodes", 0u);
-    std::vector<LinkSpec> links;
-    for (auto& l : topo["links"])
+    // Load topology JSON and routing.json, or generate/import the topology
+    TraceSpan loadSpan("load");
+    Scenario scenario;
+    std::string topoFormat =
+        importOpts.format.empty() ? TopologyFormat(topoFile) : importOpts.format;
+    bool loaded;
+    if (!gen.empty())
+        loaded = scenario.Generate(gen, routeFile);
+    else if (topoFormat != "json")
+        loaded = scenario.Import(topoFile, importOpts, routeFile);
+    else
+        loaded = scenario.Load(topoFile, routeFile.empty() ? "routing.json" : routeFile);
+    if (!loaded)
+    {
+        return 1;
+    }
+    if (routing == "source" && !scenario.GetEvents().empty())
     {
-        LinkSpec s;
-        s.src = l["src"].get<uint32_t>();
-        s.dst = l["dst"].get<uint32_t>();
-        s.bw = l.value("bandwidth", "10Mbps");
-        s.delay = l.value("delay", "10ms");
-        links.push_back(s);
+        std::cerr << "--routing=source cannot reroute around the topology's link events\n";
+        return 1;
     }
+    loadSpan.End();
 
     if (fastMode)
     {
@@ -78,232 +557,81 @@ main(int argc, char* argv[])
         NS_LOG_UNCOND("[FAST MODE] Running with reduced complexity: " << nFlows << " flows");
     }
 
-    // Create nodes
-    NodeContainer nodes;
-    nodes.Create(nNodes);
-
-    InternetStackHelper internet;
-    internet.Install(nodes);
-
-    // Mobility
-    MobilityHelper mobility;
-    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-    mobility.Install(nodes);
-
-    auto ipToStr = [](Ipv4Address addr) {
-        std::ostringstream oss;
-        addr.Print(oss);
-        return oss.str();
-    };
-
-    // Links and IPs
-    PointToPointHelper p2p;
-    p2p.SetQueue("ns3::DropTailQueue",
-                 "MaxSize",
-                 StringValue("3p")); // Very small queue to force drops
-    std::vector<NetDeviceContainer> devs;
-    Ipv4AddressHelper ipv4;
-    uint32_t subnetIndex = 1;
-
-    std::vector<std::vector<std::string>> nodeIpv4Strings(nNodes);
-    for (auto& lk : links)
+    RunConfig& cfg = scenario.Config();
+    cfg.nFlows = nFlows;
+    cfg.fastMode = fastMode;
+    cfg.metricsFile = metricsFile;
+    cfg.animFile = animFile;
+    cfg.maxTime = maxTime > 0.0 ? maxTime : (fastMode ? 12.0 : 42.0);
+    cfg.autoStop = autoStop;
+    cfg.crn = crn;
+    cfg.convergence = convergence;
+    cfg.convergence.maxTime = cfg.maxTime;
+    cfg.warmup = warmup;
+    cfg.windowInterval = windowInterval;
+    cfg.windowsFile = windowsFile;
+    cfg.mode = mode;
+    cfg.routing = routing;
+    cfg.lean = lean;
+    cfg.trainLength = trainLength;
+    cfg.useDemand = useDemand;
+    cfg.loadScale = loadScale;
+    cfg.pathTrace = pathTrace;
+    cfg.pathsFile = pathsFile;
+    cfg.pathReportFile = pathReportFile;
+    cfg.drops = drops;
+    cfg.dropsFile = dropsFile;
+    cfg.routeLogFile = routeLogFile;
+    cfg.routeLogStart = routeLogStart;
+    cfg.routeLogStop = routeLogStop;
+    cfg.envSocket = envSocket;
+    cfg.envStep = envStep;
+    cfg.envMaxActions = envMaxActions;
+    cfg.scheduler = scheduler;
+    cfg.schedTraceFile = schedTrace;
+    cfg.queues = queues;
+    cfg.eventsFile = eventsFile;
+
+    if (!loadScales.empty())
     {
-        p2p.SetDeviceAttribute("DataRate", StringValue(lk.bw));
-        p2p.SetChannelAttribute("Delay", StringValue(lk.delay));
-        NetDeviceContainer d = p2p.Install(NodeContainer(nodes.Get(lk.src), nodes.Get(lk.dst)));
-        devs.push_back(d);
-
-        std::ostringstream base;
-        base << "10." << (subnetIndex / 256) << "." << (subnetIndex % 256) << ".0";
-        ipv4.SetBase(base.str().c_str(), "255.255.255.0");
-        Ipv4InterfaceContainer ifc = ipv4.Assign(d);
-
-        nodeIpv4Strings[lk.src].push_back(ipToStr(ifc.GetAddress(0)));
-        nodeIpv4Strings[lk.dst].push_back(ipToStr(ifc.GetAddress(1)));
-        subnetIndex++;
+        return RunLoadSweep(scenario, loadScales, forkJobs, loadSweepFile);
     }
-
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
-
-    // Flows - use routing.json flow pairs if available, otherwise random
-    Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable>();
-    uint16_t basePort = 9000;
-    std::vector<std::pair<uint32_t, uint32_t>> flowPairs;
-
-    // Optional routing.json - extract both static routes and flow pairs
+    if (mode != "packet")
     {
-        std::ifstream rfs(routeFile);
-        if (rfs.is_open())
-        {
-            json rj;
-            try
-            {
-                rfs >> rj;
-
-                // Extract flow pairs from routing.json if available
-                if (rj.contains("routes"))
-                {
-                    for (auto& route : rj["routes"])
-                    {
-                        uint32_t src = route["src"];
-                        uint32_t dst = route["dst"];
-                        if (src < nNodes && dst < nNodes && src != dst)
-                        {
-                            flowPairs.emplace_back(src, dst);
-                        }
-                    }
-                    NS_LOG_UNCOND("Using " << flowPairs.size() << " flow pairs from routing.json");
-                }
-
-                // Set up static routing
-                if (rj.contains("routes"))
-                {
-                    Ipv4StaticRoutingHelper staticRoutingHelper;
-                    for (auto& entry : rj["routes"])
-                    {
-                        uint32_t src = entry["src"];
-                        uint32_t dst = entry["dst"];
-                        uint32_t next = entry["next_hop"];
-                        if (next >= nodeIpv4Strings.size() || dst >= nodeIpv4Strings.size())
-                            continue;
-                        if (nodeIpv4Strings[next].empty() || nodeIpv4Strings[dst].empty())
-                            continue;
-
-                        Ipv4Address dstAddr(nodeIpv4Strings[dst].front().c_str());
-                        Ipv4Address nextHop(nodeIpv4Strings[next].front().c_str());
-
-                        Ptr<Ipv4> ipv4ptr = nodes.Get(src)->GetObject<Ipv4>();
-                        Ptr<Ipv4StaticRouting> staticRouting =
-                            staticRoutingHelper.GetStaticRouting(ipv4ptr);
-                        staticRouting->AddHostRouteTo(dstAddr, nextHop, 1);
-                    }
-                }
-            }
-            catch (...)
-            {
-                NS_LOG_WARN("Failed to parse routing.json");
-            }
-        }
+        return scenario.Run();
     }
 
-    // If no routes in json or not enough flows, generate random ones
-    while (flowPairs.size() < (size_t)nFlows)
-    {
-        uint32_t a = rand() % nNodes;
-        uint32_t b = rand() % nNodes;
-        while (b == a)
-            b = (b + 1) % nNodes;
-        flowPairs.emplace_back(a, b);
-    }
+    scenario.Build(resilience > 0);
+    SimTopology& sim = scenario.GetTopology();
 
-    // Limit to requested number of flows
-    if (flowPairs.size() > (size_t)nFlows)
+    if (envPool > 0)
     {
-        flowPairs.resize(nFlows);
+        EnvPool pool(sim, cfg, envPool, envEpisodes > 0 ? envEpisodes : envPool);
+        int rc = pool.Run();
+        Simulator::Destroy();
+        return rc;
     }
-
-    // Create flows using the flow pairs
-    for (size_t f = 0; f < flowPairs.size(); ++f)
+    if (resilience > 0)
     {
-        uint32_t a = flowPairs[f].first;
-        uint32_t b = flowPairs[f].second;
-
-        if (nodeIpv4Strings[b].empty())
-            continue;
-        Ipv4Address dstIp(nodeIpv4Strings[b].front().c_str());
-
-        uint16_t port = basePort + f;
-        PacketSinkHelper sink("ns3::UdpSocketFactory",
-                              InetSocketAddress(Ipv4Address::GetAny(), port));
-        ApplicationContainer sapps = sink.Install(nodes.Get(b));
-        sapps.Start(Seconds(0.5));
-        sapps.Stop(Seconds(fastMode ? 10.0 : 40.0));
-
-        OnOffHelper onoff("ns3::UdpSocketFactory", Address(InetSocketAddress(dstIp, port)));
-        onoff.SetConstantRate(
-            DataRate(fastMode ? "2Mbps" : "8Mbps")); // Higher data rate for congestion
-        onoff.SetAttribute("PacketSize", UintegerValue(512));
-
-        ApplicationContainer apps = onoff.Install(nodes.Get(a));
-        double start = 1.0 + rv->GetValue(0, 5); // Random start times for burst patterns
-        apps.Start(Seconds(start));
-        apps.Stop(Seconds(fastMode ? 9.0 : 38.0));
+        int rc = RunResilienceSweep(sim, scenario.GetLinks(), cfg, resilience, forkJobs, sweepFile);
+        Simulator::Destroy();
+        return rc;
     }
-
-    // Optional animation
-    AnimationInterface* anim = nullptr;
-    if (!fastMode)
+    if (replicate > 0)
     {
-        anim = new AnimationInterface(animFile);
-        anim->SetMaxPktsPerTraceFile(500000); // Increase trace buffer
-        double spacing = 30.0;
-        for (uint32_t i = 0; i < nNodes; ++i)
-        {
-            double x = (i % 6) * spacing + 10;
-            double y = (i / 6) * spacing + 10;
-            anim->SetConstantPosition(nodes.Get(i), x, y, 0.0);
-        }
-        anim->EnableIpv4RouteTracking("routes.xml", Seconds(0), Seconds(20), Seconds(5.0));
+        int rc =
+            RunReplications(sim, cfg, replicate, repMin, repWidth, forkJobs, replicateFile);
+        Simulator::Destroy();
+        return rc;
     }
-
-    // Flow monitor
-    FlowMonitorHelper flowmon;
-    Ptr<FlowMonitor> monitor = flowmon.InstallAll();
-
-    Simulator::Stop(Seconds(fastMode ? 12.0 : 42.0));
-    Simulator::Run();
-
-    // Collect metrics
-    monitor->CheckForLostPackets();
-    Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flowmon.GetClassifier());
-    auto stats = monitor->GetFlowStats();
-
-    std::ofstream csv(metricsFile);
-    csv << "flow_id,src_idx,dst_idx,src_ip,dst_ip,txPkts,rxPkts,txBytes,rxBytes,throughput_mbps,"
-           "avg_delay_ms,loss_pct\n";
-    for (auto& kv : stats)
+    if (forkSeeds > 0)
     {
-        FlowId id = kv.first;
-        FlowMonitor::FlowStats fs = kv.second;
-        Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(id);
-
-        std::ostringstream srcOss, dstOss;
-        t.sourceAddress.Print(srcOss);
-        t.destinationAddress.Print(dstOss);
-
-        std::string srcIp = srcOss.str(), dstIp = dstOss.str();
-        int srcIdx = -1, dstIdx = -1;
-
-        for (uint32_t n = 0; n < nodeIpv4Strings.size(); ++n)
-        {
-            for (auto& s : nodeIpv4Strings[n])
-            {
-                if (s == srcIp)
-                    srcIdx = n;
-                if (s == dstIp)
-                    dstIdx = n;
-            }
-        }
-
-        double duration = fs.timeLastRxPacket.GetSeconds() - fs.timeFirstTxPacket.GetSeconds();
-        double throughput = (duration > 0.0) ? (fs.rxBytes * 8.0) / (duration * 1e6) : 0.0;
-        double avgDelay =
-            (fs.rxPackets > 0) ? (fs.delaySum.GetSeconds() / fs.rxPackets) * 1000.0 : 0.0;
-        double lossPct =
-            (fs.txPackets > 0) ? (fs.txPackets - fs.rxPackets) / fs.txPackets * 100.0 : 0.0;
-
-        csv << id << "," << srcIdx << "," << dstIdx << "," << srcIp << "," << dstIp << ","
-            << fs.txPackets << "," << fs.rxPackets << "," << fs.txBytes << "," << fs.rxBytes << ","
-            << throughput << "," << avgDelay << "," << lossPct << "\n";
+        int rc = RunForkedSeeds(sim, cfg, forkSeeds, forkJobs);
+        Simulator::Destroy();
+        return rc;
     }
-
-    csv.close();
-    monitor->SerializeToXmlFile("flowmon-results.xml", true, true);
-
-    if (anim)
-        delete anim;
-    Simulator::Destroy();
-
-    NS_LOG_UNCOND("Simulation complete → Metrics written to " << metricsFile);
-    return 0;
+    int rc = scenario.Run();
+    if (trace && !trace->Write(traceFile))
+        rc = 1;
+    return rc;
 }
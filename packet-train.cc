@@ -0,0 +1,96 @@
+#include "packet-train.h"
+
+#include "ns3/internet-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("PacketTrain");
+
+NS_OBJECT_ENSURE_REGISTERED(PacketTrainApplication);
+
+TypeId
+PacketTrainApplication::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::PacketTrainApplication")
+            .SetParent<Application>()
+            .SetGroupName("Applications")
+            .AddConstructor<PacketTrainApplication>()
+            .AddAttribute("Remote",
+                          "Destination address and port",
+                          AddressValue(),
+                          MakeAddressAccessor(&PacketTrainApplication::m_remote),
+                          MakeAddressChecker())
+            .AddAttribute("DataRate",
+                          "Average sending rate",
+                          DataRateValue(DataRate("8Mbps")),
+                          MakeDataRateAccessor(&PacketTrainApplication::m_rate),
+                          MakeDataRateChecker())
+            .AddAttribute("PacketSize",
+                          "Bytes per packet",
+                          UintegerValue(512),
+                          MakeUintegerAccessor(&PacketTrainApplication::m_packetSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("TrainLength",
+                          "Packets sent back to back per event",
+                          UintegerValue(8),
+                          MakeUintegerAccessor(&PacketTrainApplication::m_trainLength),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddTraceSource("Tx",
+                            "A packet has been sent",
+                            MakeTraceSourceAccessor(&PacketTrainApplication::m_txTrace),
+                            "ns3::Packet::TracedCallback");
+    return tid;
+}
+
+uint64_t
+PacketTrainApplication::GetTotalTx() const
+{
+    return m_totalTx;
+}
+
+void
+PacketTrainApplication::DoDispose()
+{
+    m_socket = nullptr;
+    Application::DoDispose();
+}
+
+void
+PacketTrainApplication::StartApplication()
+{
+    if (!m_socket)
+    {
+        m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+        m_socket->Bind();
+        m_socket->Connect(m_remote);
+        m_socket->ShutdownRecv();
+    }
+    SendTrain();
+}
+
+void
+PacketTrainApplication::StopApplication()
+{
+    Simulator::Cancel(m_sendEvent);
+    if (m_socket)
+    {
+        m_socket->Close();
+    }
+}
+
+void
+PacketTrainApplication::SendTrain()
+{
+    for (uint32_t i = 0; i < m_trainLength; ++i)
+    {
+        Ptr<Packet> p = Create<Packet>(m_packetSize);
+        m_txTrace(p);
+        if (m_socket->Send(p) >= 0)
+            m_totalTx += m_packetSize;
+    }
+    // The next train leaves once this one's bits have drained at the average rate
+    m_sendEvent = Simulator::Schedule(m_rate.CalculateBytesTxTime(m_packetSize * m_trainLength),
+                                      &PacketTrainApplication::SendTrain,
+                                      this);
+}
@@ -0,0 +1,40 @@
+#ifndef PACKET_TRAIN_H
+#define PACKET_TRAIN_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <cstdint>
+
+// Constant-rate UDP source that sends TrainLength packets back to back per
+// scheduled event and then waits TrainLength packet times, so the average
+// rate matches OnOffApplication's constant rate with 1/TrainLength of its
+// send events (--train=K). Packets stay PacketSize bytes, so per-packet
+// statistics and queueing are unchanged apart from the burstiness.
+class PacketTrainApplication : public ns3::Application
+{
+  public:
+    static ns3::TypeId GetTypeId();
+
+    uint64_t GetTotalTx() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    void StartApplication() override;
+    void StopApplication() override;
+    void SendTrain();
+
+    ns3::Address m_remote;
+    ns3::DataRate m_rate;
+    uint32_t m_packetSize = 512;
+    uint32_t m_trainLength = 8;
+    ns3::Ptr<ns3::Socket> m_socket;
+    ns3::EventId m_sendEvent;
+    uint64_t m_totalTx = 0;
+    ns3::TracedCallback<ns3::Ptr<const ns3::Packet>> m_txTrace;
+};
+
+#endif // PACKET_TRAIN_H
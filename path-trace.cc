@@ -0,0 +1,359 @@
+#include "path-trace.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("PathTrace");
+
+NS_OBJECT_ENSURE_REGISTERED(PathTraceTag);
+
+static std::string
+PathString(const std::vector<uint32_t>& path)
+{
+    if (path.empty())
+        return "-";
+    std::ostringstream oss;
+    for (size_t i = 0; i < path.size(); ++i)
+        oss << (i ? "-" : "") << path[i];
+    return oss.str();
+}
+
+TypeId
+PathTraceTag::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::PathTraceTag")
+                            .SetParent<Tag>()
+                            .SetGroupName("Internet")
+                            .AddConstructor<PathTraceTag>();
+    return tid;
+}
+
+TypeId
+PathTraceTag::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+PathTraceTag::GetSerializedSize() const
+{
+    return 1 + 2 * std::min<uint32_t>(m_nHops, kMaxHops);
+}
+
+void
+PathTraceTag::Serialize(TagBuffer buf) const
+{
+    buf.WriteU8(m_nHops | (m_unrecordable ? kUnrecordable : 0));
+    for (uint32_t i = 0; i < std::min<uint32_t>(m_nHops, kMaxHops); ++i)
+        buf.WriteU16(m_hops[i]);
+}
+
+void
+PathTraceTag::Deserialize(TagBuffer buf)
+{
+    uint8_t count = buf.ReadU8();
+    m_nHops = count & kMaxCount;
+    m_unrecordable = count & kUnrecordable;
+    for (uint32_t i = 0; i < std::min<uint32_t>(m_nHops, kMaxHops); ++i)
+        m_hops[i] = buf.ReadU16();
+}
+
+void
+PathTraceTag::Print(std::ostream& os) const
+{
+    if (m_unrecordable)
+        os << "path=unrecordable";
+    else
+        os << "path=" << PathString(GetHops()) << (IsTruncated() ? "..." : "");
+}
+
+void
+PathTraceTag::AddHop(uint32_t node)
+{
+    if (node > UINT16_MAX)
+        m_unrecordable = true;
+    if (m_nHops < kMaxHops)
+        m_hops[m_nHops] = uint16_t(node);
+    if (m_nHops < kMaxCount)
+        m_nHops++;
+}
+
+uint32_t
+PathTraceTag::GetNHops() const
+{
+    return m_nHops;
+}
+
+bool
+PathTraceTag::IsTruncated() const
+{
+    return m_nHops > kMaxHops;
+}
+
+bool
+PathTraceTag::IsUnrecordable() const
+{
+    return m_unrecordable;
+}
+
+std::vector<uint32_t>
+PathTraceTag::GetHops() const
+{
+    return std::vector<uint32_t>(m_hops, m_hops + std::min<uint32_t>(m_nHops, kMaxHops));
+}
+
+PathTracer::PathTracer(const NodeContainer& nodes,
+                       uint32_t sampleEvery,
+                       uint16_t basePort,
+                       const std::vector<std::pair<uint32_t, uint32_t>>& flowPairs,
+                       const std::vector<std::vector<uint32_t>>& expected)
+    : m_sampleEvery(std::max<uint32_t>(sampleEvery, 1)),
+      m_basePort(basePort),
+      m_flowPairs(flowPairs),
+      m_expected(expected),
+      m_flows(flowPairs.size())
+{
+    using PacketTrace = Callback<void, const Ipv4Header&, Ptr<const Packet>, uint32_t>;
+    using DropTrace = Callback<void,
+                               const Ipv4Header&,
+                               Ptr<const Packet>,
+                               Ipv4L3Protocol::DropReason,
+                               Ptr<Ipv4>,
+                               uint32_t>;
+    for (uint32_t n = 0; n < nodes.GetN(); ++n)
+    {
+        Ptr<Ipv4L3Protocol> ipv4 = nodes.Get(n)->GetObject<Ipv4L3Protocol>();
+        ipv4->TraceConnectWithoutContext(
+            "SendOutgoing",
+            PacketTrace([this, n](const Ipv4Header& h, Ptr<const Packet> p, uint32_t) {
+                Outgoing(n, h, p);
+            }));
+        ipv4->TraceConnectWithoutContext(
+            "UnicastForward",
+            PacketTrace([this, n](const Ipv4Header& h, Ptr<const Packet> p, uint32_t) {
+                Forward(n, h, p);
+            }));
+        ipv4->TraceConnectWithoutContext(
+            "LocalDeliver",
+            PacketTrace([this, n](const Ipv4Header& h, Ptr<const Packet> p, uint32_t) {
+                Deliver(n, h, p);
+            }));
+        ipv4->TraceConnectWithoutContext(
+            "Drop",
+            DropTrace([this, n](const Ipv4Header& h,
+                                Ptr<const Packet> p,
+                                Ipv4L3Protocol::DropReason reason,
+                                Ptr<Ipv4>,
+                                uint32_t) { Drop(n, h, p, reason); }));
+    }
+}
+
+int64_t
+PathTracer::FlowOf(const Ipv4Header& header, Ptr<const Packet> p) const
+{
+    if (header.GetProtocol() != UdpL4Protocol::PROT_NUMBER)
+        return -1;
+    UdpHeader udp;
+    p->PeekHeader(udp);
+    int64_t flow = int64_t(udp.GetDestinationPort()) - m_basePort;
+    return flow >= 0 && flow < int64_t(m_flows.size()) ? flow : -1;
+}
+
+void
+PathTracer::Outgoing(uint32_t node, const Ipv4Header& header, Ptr<const Packet> p)
+{
+    int64_t flow = FlowOf(header, p);
+    if (flow < 0 || m_flows[flow].sent++ % m_sampleEvery != 0)
+        return;
+    PathTraceTag tag;
+    tag.AddHop(node);
+    p->AddPacketTag(tag);
+}
+
+void
+PathTracer::Forward(uint32_t node, const Ipv4Header& header, Ptr<const Packet> p)
+{
+    PathTraceTag tag;
+    if (!p->PeekPacketTag(tag))
+        return;
+    tag.AddHop(node);
+    // The forwarded copy is the packet sent on, so the tag must change in place
+    ConstCast<Packet>(p)->ReplacePacketTag(tag);
+}
+
+void
+PathTracer::Deliver(uint32_t node, const Ipv4Header& header, Ptr<const Packet> p)
+{
+    PathTraceTag tag;
+    int64_t flow = FlowOf(header, p);
+    if (flow < 0 || !p->PeekPacketTag(tag))
+        return;
+    tag.AddHop(node);
+    Record(flow, tag, false);
+}
+
+void
+PathTracer::Drop(uint32_t node,
+                 const Ipv4Header& header,
+                 Ptr<const Packet> p,
+                 Ipv4L3Protocol::DropReason reason)
+{
+    if (reason != Ipv4L3Protocol::DROP_TTL_EXPIRED)
+        return;
+    int64_t flow = FlowOf(header, p);
+    if (flow < 0)
+    {
+        m_otherTtlExpired++;
+        return;
+    }
+    m_flows[flow].ttlExpired++;
+    PathTraceTag tag;
+    if (p->PeekPacketTag(tag))
+    {
+        tag.AddHop(node);
+        Record(flow, tag, true);
+    }
+}
+
+PathTracer::PathStatus
+PathTracer::Classify(uint32_t flow, const PathTraceTag& tag) const
+{
+    if (tag.IsUnrecordable())
+        return PathStatus::UNRECORDABLE;
+    if (tag.IsTruncated())
+        return PathStatus::TRUNCATED;
+    std::vector<uint32_t> hops = tag.GetHops();
+    std::vector<uint32_t> sorted = hops;
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+        return PathStatus::LOOP;
+    if (m_expected[flow].empty())
+        return PathStatus::NO_PATH;
+    return hops == m_expected[flow] ? PathStatus::MATCH : PathStatus::MISMATCH;
+}
+
+void
+PathTracer::Record(uint32_t flow, const PathTraceTag& tag, bool expired)
+{
+    PathStatus status = expired ? PathStatus::TTL_EXPIRED : Classify(flow, tag);
+    // Unrecordable hops are cut to 16 bits, so keep no path for them
+    std::vector<uint32_t> hops;
+    if (!tag.IsUnrecordable())
+        hops = tag.GetHops();
+    m_flows[flow].paths[{hops, status}]++;
+}
+
+const char*
+PathTracer::StatusName(PathStatus status)
+{
+    switch (status)
+    {
+    case PathStatus::MATCH:
+        return "match";
+    case PathStatus::MISMATCH:
+        return "mismatch";
+    case PathStatus::LOOP:
+        return "loop";
+    case PathStatus::TRUNCATED:
+        return "truncated";
+    case PathStatus::TTL_EXPIRED:
+        return "ttl_expired";
+    case PathStatus::NO_PATH:
+        return "no_path";
+    case PathStatus::UNRECORDABLE:
+        return "unrecordable";
+    }
+    return "";
+}
+
+void
+PathTracer::WritePaths(const std::string& file) const
+{
+    std::ofstream out(file);
+    out << "flow,src,dst,port,observed_path,status,packets\n";
+    for (uint32_t f = 0; f < m_flows.size(); ++f)
+    {
+        for (auto& kv : m_flows[f].paths)
+        {
+            out << f << "," << m_flowPairs[f].first << "," << m_flowPairs[f].second << ","
+                << m_basePort + f << "," << PathString(kv.first.first) << ","
+                << StatusName(kv.first.second) << "," << kv.second << "\n";
+        }
+    }
+}
+
+void
+PathTracer::WriteReport(const std::string& file) const
+{
+    std::ofstream out(file);
+    out << "flow,src,dst,port,expected_path,sent,sampled,matched,mismatched,looped,ttl_expired,"
+           "top_path\n";
+    for (uint32_t f = 0; f < m_flows.size(); ++f)
+    {
+        const FlowTrace& t = m_flows[f];
+        uint64_t sampled = 0, matched = 0, mismatched = 0, looped = 0, top = 0;
+        const std::vector<uint32_t>* topPath = nullptr;
+        for (auto& kv : t.paths)
+        {
+            sampled += kv.second;
+            switch (kv.first.second)
+            {
+            case PathStatus::MATCH:
+                matched += kv.second;
+                break;
+            case PathStatus::MISMATCH:
+                mismatched += kv.second;
+                break;
+            case PathStatus::LOOP:
+            case PathStatus::TRUNCATED:
+                looped += kv.second;
+                break;
+            default:
+                break;
+            }
+            if (kv.second > top)
+            {
+                top = kv.second;
+                topPath = &kv.first.first;
+            }
+        }
+        out << f << "," << m_flowPairs[f].first << "," << m_flowPairs[f].second << ","
+            << m_basePort + f << "," << PathString(m_expected[f]) << "," << t.sent << ","
+            << sampled << "," << matched << "," << mismatched << "," << looped << ","
+            << t.ttlExpired << "," << (topPath ? PathString(*topPath) : "-") << "\n";
+    }
+    if (m_otherTtlExpired > 0)
+        out << "-,-,-,-,-,0,0,0,0,0," << m_otherTtlExpired << ",-\n";
+}
+
+uint32_t
+PathTracer::GetNMismatchedFlows() const
+{
+    uint32_t n = 0;
+    for (auto& t : m_flows)
+    {
+        for (auto& kv : t.paths)
+        {
+            PathStatus status = kv.first.second;
+            if (status != PathStatus::MATCH && status != PathStatus::NO_PATH &&
+                status != PathStatus::UNRECORDABLE)
+            {
+                n++;
+                break;
+            }
+        }
+    }
+    return n;
+}
+
+uint64_t
+PathTracer::GetNTtlExpired() const
+{
+    uint64_t n = m_otherTtlExpired;
+    for (auto& t : m_flows)
+        n += t.ttlExpired;
+    return n;
+}
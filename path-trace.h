@@ -0,0 +1,116 @@
+#ifndef PATH_TRACE_H
+#define PATH_TRACE_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Packet tag listing the nodes a sampled packet has left so far. ns-3 caps
+// packet tags at 21 bytes: one hop count and up to kMaxHops 16-bit node
+// indices. The count keeps rising past kMaxHops so long paths and loops show
+// up as truncated rather than silently cut. A hop through a node index that
+// does not fit in 16 bits marks the path unrecordable instead.
+class PathTraceTag : public ns3::Tag
+{
+  public:
+    static const uint32_t kMaxHops = 10;
+
+    static ns3::TypeId GetTypeId();
+    ns3::TypeId GetInstanceTypeId() const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(ns3::TagBuffer buf) const override;
+    void Deserialize(ns3::TagBuffer buf) override;
+    void Print(std::ostream& os) const override;
+
+    void AddHop(uint32_t node);
+    // Hops recorded, including those past kMaxHops that did not fit.
+    uint32_t GetNHops() const;
+    bool IsTruncated() const;
+    // A hop was a node index above 65535.
+    bool IsUnrecordable() const;
+    // Recorded node indices, at most kMaxHops.
+    std::vector<uint32_t> GetHops() const;
+
+  private:
+    static const uint8_t kUnrecordable = 0x80; // flag in the serialized count
+    static const uint8_t kMaxCount = 0x7f;
+
+    uint8_t m_nHops = 0;
+    bool m_unrecordable = false;
+    uint16_t m_hops[kMaxHops];
+};
+
+// Records the forwarding path of 1 in `sampleEvery` packets of each flow with
+// a PathTraceTag, hooked to the Ipv4L3Protocol traces of every node: the
+// source adds itself on SendOutgoing, routers on UnicastForward and the
+// destination on LocalDeliver. Flows are told apart by their destination
+// port (basePort + flow index), as installed by RunTraffic. TTL expiries are
+// counted for every packet; sampled ones also keep the partial path.
+class PathTracer
+{
+  public:
+    // `expected[f]` is flow f's routing.json path (empty if it has none).
+    PathTracer(const ns3::NodeContainer& nodes,
+               uint32_t sampleEvery,
+               uint16_t basePort,
+               const std::vector<std::pair<uint32_t, uint32_t>>& flowPairs,
+               const std::vector<std::vector<uint32_t>>& expected);
+
+    // Observed path histogram: one row per flow and distinct path.
+    void WritePaths(const std::string& file) const;
+    // One row per flow comparing the observed paths with routing.json.
+    void WriteReport(const std::string& file) const;
+    // Flows with sampled packets off their routing.json path.
+    uint32_t GetNMismatchedFlows() const;
+    uint64_t GetNTtlExpired() const;
+
+  private:
+    // How a sampled packet's path compares with the flow's routing.json path
+    enum class PathStatus
+    {
+        MATCH,
+        MISMATCH,
+        LOOP,
+        TRUNCATED,
+        TTL_EXPIRED,
+        NO_PATH,
+        UNRECORDABLE,
+    };
+
+    struct FlowTrace
+    {
+        uint64_t sent = 0;
+        uint64_t ttlExpired = 0;
+        std::map<std::pair<std::vector<uint32_t>, PathStatus>, uint64_t> paths;
+    };
+
+    // Flow index of a UDP packet from its destination port, or -1.
+    int64_t FlowOf(const ns3::Ipv4Header& header, ns3::Ptr<const ns3::Packet> p) const;
+    PathStatus Classify(uint32_t flow, const PathTraceTag& tag) const;
+    void Record(uint32_t flow, const PathTraceTag& tag, bool expired);
+
+    void Outgoing(uint32_t node, const ns3::Ipv4Header& header, ns3::Ptr<const ns3::Packet> p);
+    void Forward(uint32_t node, const ns3::Ipv4Header& header, ns3::Ptr<const ns3::Packet> p);
+    void Deliver(uint32_t node, const ns3::Ipv4Header& header, ns3::Ptr<const ns3::Packet> p);
+    void Drop(uint32_t node,
+              const ns3::Ipv4Header& header,
+              ns3::Ptr<const ns3::Packet> p,
+              ns3::Ipv4L3Protocol::DropReason reason);
+
+    static const char* StatusName(PathStatus status);
+
+    uint32_t m_sampleEvery;
+    uint16_t m_basePort;
+    std::vector<std::pair<uint32_t, uint32_t>> m_flowPairs;
+    std::vector<std::vector<uint32_t>> m_expected;
+    std::vector<FlowTrace> m_flows;
+    uint64_t m_otherTtlExpired = 0; // non-flow packets, e.g. ICMP
+};
+
+#endif // PATH_TRACE_H
@@ -0,0 +1,146 @@
+"""
+Agent side of ns3_sim's step-wise environment (--env=PATH, optionally with
+--envPool=N for N environments stepped in lockstep).
+
+The simulator blocks at every step until the agent replies. Observations are
+NumPy views straight into the shared file PATH.shm, one row per environment
+(shape (n_envs, ...)), so reading them copies nothing; they are overwritten at
+the next step. Layout: step-env.h.
+
+    env = Ns3StepEnv("/tmp/ns3-env")      # after starting ns3_sim --env=/tmp/ns3-env
+    obs = env.reset()
+    while not env.done:
+        actions = agent(obs)               # per environment, rows of (node, destination, next hop)
+        obs = env.step(actions)
+
+obs["done"][i] is 1 on environment i's final observation of an episode (a pool
+starts the next one in that slot) and 2 on the slot's last one; env.done is
+set once every slot reached 2 or the simulator hung up.
+"""
+
+import mmap
+import os
+import socket
+import struct
+import time
+
+import numpy as np
+
+ENV_MAGIC = 0x4E533345
+ENV_VERSION = 2
+HEADER = struct.Struct("=8I")  # EnvHeader, 32 bytes
+STATE = np.dtype(
+    [
+        ("step", "=u8"),
+        ("time", "=f8"),
+        ("done", "=u4"),
+        ("n_actions", "=u4"),
+        ("applied", "=u4"),
+        ("rejected", "=u4"),
+        ("episode", "=u4"),
+        ("reserved", "=u4"),
+    ]
+)  # EnvState, 40 bytes
+CONTINUE, STOP = 1, 0
+
+
+class Ns3StepEnv:
+    def __init__(self, path, connect_timeout=60.0):
+        self.path = path
+        self.connect_timeout = connect_timeout
+        self.sock = None
+        self.shm = None
+        self.done = False
+
+    def reset(self):
+        """Connect to a waiting simulator and return the first observation."""
+        deadline = time.monotonic() + self.connect_timeout
+        while True:
+            try:
+                self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+                self.sock.connect(self.path)
+                break
+            except (FileNotFoundError, ConnectionRefusedError):
+                self.sock.close()
+                if time.monotonic() > deadline:
+                    raise TimeoutError(f"no simulator listening on {self.path}")
+                time.sleep(0.05)
+
+        with open(self.path + ".shm", "r+b") as f:
+            self.shm = mmap.mmap(f.fileno(), os.fstat(f.fileno()).st_size)
+        magic, version, n_envs, n_nodes, n_links, n_flows, max_actions, _ = HEADER.unpack_from(
+            self.shm
+        )
+        if magic != ENV_MAGIC or version != ENV_VERSION:
+            raise RuntimeError(f"{self.path}.shm is not a version {ENV_VERSION} ns3_sim environment")
+        self.n_envs, self.n_nodes, self.n_links, self.n_flows = n_envs, n_nodes, n_links, n_flows
+        self.max_actions = max_actions
+
+        off = HEADER.size
+
+        def view(dtype, shape):
+            nonlocal off
+            a = np.frombuffer(self.shm, dtype=dtype, count=int(np.prod(shape)), offset=off)
+            off += a.nbytes
+            return a.reshape(shape)
+
+        self.state = view(STATE, (n_envs,))
+        self.link_util = view(np.float64, (n_envs, n_links))
+        self.queue_packets = view(np.float64, (n_envs, n_links))
+        self.flow_mbps = view(np.float64, (n_envs, n_flows))
+        self.link_ends = view(np.uint32, (n_links, 2))
+        self.flow_ends = view(np.uint32, (n_envs, n_flows, 2))
+        self._actions = view(np.uint32, (n_envs, max_actions, 3))
+        self.done = False
+        return self._wait()
+
+    def step(self, actions=None, stop=False):
+        """Install `actions` and advance one step.
+
+        `actions` is a list with one N x 3 array (node, destination, next hop)
+        per environment, or None; a single environment also takes the array.
+        """
+        if actions is not None and self.n_envs == 1 and np.ndim(actions) == 2:
+            actions = [actions]
+        for i in range(self.n_envs):
+            rows = actions[i] if actions is not None else None
+            n = 0
+            if rows is not None and len(rows):
+                rows = np.asarray(rows, dtype=np.uint32).reshape(-1, 3)
+                n = min(len(rows), self.max_actions)
+                self._actions[i, :n] = rows[:n]
+            self.state["n_actions"][i] = n
+        self.sock.sendall(struct.pack("=I", STOP if stop else CONTINUE))
+        if stop:
+            self.close()
+            return None
+        return self._wait()
+
+    def _wait(self):
+        buf = b""
+        while len(buf) < 8:
+            chunk = self.sock.recv(8 - len(buf))
+            if not chunk:
+                self.done = True
+                break
+            buf += chunk
+        self.done = self.done or bool((self.state["done"] == 2).all())
+        if self.done:
+            self.close()
+        return {
+            "step": self.state["step"],
+            "time": self.state["time"],
+            "done": self.state["done"],
+            "episode": self.state["episode"],
+            "applied": self.state["applied"],
+            "rejected": self.state["rejected"],
+            "link_util": self.link_util,
+            "queue_packets": self.queue_packets,
+            "flow_mbps": self.flow_mbps,
+            "flow_ends": self.flow_ends,
+        }
+
+    def close(self):
+        if self.sock is not None:
+            self.sock.close()
+            self.sock = None
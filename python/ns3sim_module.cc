@@ -0,0 +1,181 @@
+// Python bindings for the ns3_sim scenario library. Built by setup.py in this
+// directory (not by the ns-3 scratch build, which only compiles the parent).
+#include "../scenario.h"
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <stdexcept>
+
+namespace py = pybind11;
+
+namespace
+{
+
+using ResultsPtr = std::shared_ptr<const FlowResults>;
+
+// Read-only NumPy view of one results column. The capsule holds a reference to
+// that run's FlowResults, so the array outlives later runs and the Scenario.
+template <typename T>
+py::array_t<T>
+ColumnView(const ResultsPtr& results, std::vector<T> FlowResults::*column)
+{
+    static const std::vector<T> empty;
+    const std::vector<T>& v = results ? (*results).*column : empty;
+    py::capsule owner(new ResultsPtr(results),
+                      [](void* p) { delete static_cast<ResultsPtr*>(p); });
+    py::array_t<T> a(v.size(), v.data(), owner);
+    a.attr("setflags")(py::arg("write") = false);
+    return a;
+}
+
+py::dict
+ResultsDict(const ResultsPtr& r)
+{
+    py::dict d;
+    d["flow_id"] = ColumnView(r, &FlowResults::flowId);
+    d["src_idx"] = ColumnView(r, &FlowResults::src);
+    d["dst_idx"] = ColumnView(r, &FlowResults::dst);
+    d["tx_packets"] = ColumnView(r, &FlowResults::txPackets);
+    d["rx_packets"] = ColumnView(r, &FlowResults::rxPackets);
+    d["tx_bytes"] = ColumnView(r, &FlowResults::txBytes);
+    d["rx_bytes"] = ColumnView(r, &FlowResults::rxBytes);
+    d["throughput_mbps"] = ColumnView(r, &FlowResults::throughputMbps);
+    d["avg_delay_ms"] = ColumnView(r, &FlowResults::delayMs);
+    d["loss_pct"] = ColumnView(r, &FlowResults::lossPct);
+    return d;
+}
+
+} // namespace
+
+PYBIND11_MODULE(ns3sim, m)
+{
+    m.doc() = "In-process ns3_sim: load a topology, set routes, run, read results as NumPy";
+
+    m.def(
+        "set_seed",
+        [](uint32_t seed, uint64_t run) {
+            ns3::RngSeedManager::SetSeed(seed);
+            ns3::RngSeedManager::SetRun(run);
+        },
+        py::arg("seed"),
+        py::arg("run") = 1);
+
+    py::class_<RouteSpec>(m, "Route")
+        .def(py::init([](uint32_t src,
+                         uint32_t dst,
+                         uint32_t nextHop,
+                         std::vector<uint32_t> path,
+                         double demand) {
+                 return RouteSpec{src, dst, nextHop, std::move(path), demand};
+             }),
+             py::arg("src"),
+             py::arg("dst"),
+             py::arg("next_hop"),
+             py::arg("path") = std::vector<uint32_t>(),
+             py::arg("demand") = 0.0)
+        .def_readwrite("src", &RouteSpec::src)
+        .def_readwrite("dst", &RouteSpec::dst)
+        .def_readwrite("next_hop", &RouteSpec::nextHop)
+        .def_readwrite("path", &RouteSpec::path)
+        .def_readwrite("demand", &RouteSpec::demand);
+
+    py::class_<RunConfig>(m, "Config")
+        .def_readwrite("flows", &RunConfig::nFlows)
+        .def_readwrite("fast", &RunConfig::fastMode)
+        .def_readwrite("max_time", &RunConfig::maxTime)
+        .def_readwrite("auto_stop", &RunConfig::autoStop)
+        .def_readwrite("crn", &RunConfig::crn)
+        .def_readwrite("warmup", &RunConfig::warmup)
+        .def_readwrite("window", &RunConfig::windowInterval)
+        .def_readwrite("mode", &RunConfig::mode)
+        .def_readwrite("routing", &RunConfig::routing)
+        .def_readwrite("lean", &RunConfig::lean)
+        .def_readwrite("train", &RunConfig::trainLength)
+        .def_readwrite("use_demand", &RunConfig::useDemand)
+        .def_readwrite("load_scale", &RunConfig::loadScale)
+        .def_readwrite("path_trace", &RunConfig::pathTrace)
+        .def_readwrite("drops", &RunConfig::drops)
+        .def_readwrite("env", &RunConfig::envSocket)
+        .def_readwrite("env_step", &RunConfig::envStep)
+        .def_readwrite("env_max_actions", &RunConfig::envMaxActions)
+        .def_readwrite("scheduler", &RunConfig::scheduler)
+        .def_readwrite("anim", &RunConfig::anim)
+        .def_readwrite("anim_file", &RunConfig::animFile)
+        .def_readwrite("metrics", &RunConfig::metricsFile)
+        .def_readwrite("flowmon", &RunConfig::flowmonFile)
+        .def_readwrite("windows_out", &RunConfig::windowsFile)
+        .def_readwrite("events_out", &RunConfig::eventsFile)
+        .def_readwrite("paths_out", &RunConfig::pathsFile)
+        .def_readwrite("path_report_out", &RunConfig::pathReportFile)
+        .def_readwrite("drops_out", &RunConfig::dropsFile)
+        .def_readwrite("route_log", &RunConfig::routeLogFile)
+        .def_readwrite("route_log_start", &RunConfig::routeLogStart)
+        .def_readwrite("route_log_stop", &RunConfig::routeLogStop);
+
+    py::class_<Scenario>(m, "Scenario")
+        .def(py::init([]() {
+            // No file output unless asked for; results come back as arrays
+            auto s = std::make_unique<Scenario>();
+            s->Config().DisableFileOutput();
+            return s;
+        }))
+        .def(
+            "load",
+            [](Scenario& s, const std::string& topo, const std::string& routes) {
+                if (!s.Load(topo, routes))
+                    throw std::runtime_error("cannot load topology " + topo);
+            },
+            py::arg("topo"),
+            py::arg("routes") = "")
+        .def(
+            "generate",
+            [](Scenario& s, const std::string& spec, const std::string& routes) {
+                if (!s.Generate(spec, routes))
+                    throw std::runtime_error("cannot generate topology " + spec);
+            },
+            py::arg("spec"),
+            py::arg("routes") = "")
+        .def(
+            "import_topology",
+            [](Scenario& s,
+               const std::string& file,
+               const std::string& format,
+               const std::string& bw,
+               const std::string& delay,
+               const std::string& routes) {
+                ImportOptions opts;
+                opts.format = format;
+                opts.bw = bw;
+                opts.delay = delay;
+                if (!s.Import(file, opts, routes))
+                    throw std::runtime_error("cannot import topology " + file);
+            },
+            py::arg("file"),
+            py::arg("format") = "",
+            py::arg("bw") = "10Mbps",
+            py::arg("delay") = "1ms",
+            py::arg("routes") = "")
+        .def("set_routes", &Scenario::SetRoutes, py::arg("routes"))
+        .def_property_readonly("routes", &Scenario::GetRoutes)
+        .def_property_readonly("config",
+                               &Scenario::Config,
+                               py::return_value_policy::reference_internal)
+        .def("build", &Scenario::Build, py::arg("link_events") = false)
+        .def("run", &Scenario::Run, py::call_guard<py::gil_scoped_release>())
+        .def("results", [](const Scenario& s) { return ResultsDict(s.GetResults()); })
+        .def("summary", [](const Scenario& s) {
+            const RunSummary& r = s.GetSummary();
+            py::dict d;
+            d["flows"] = r.flows;
+            d["offered_mbps"] = r.offeredMbps;
+            d["throughput_mbps"] = r.throughputMbps;
+            d["loss_pct"] = r.LossPct();
+            d["p99_delay_ms"] = r.P99DelayMs();
+            d["worst_throughput_mbps"] = r.worstThroughput;
+            d["worst_src"] = r.worstSrc;
+            d["worst_dst"] = r.worstDst;
+            return d;
+        });
+}
@@ -0,0 +1,61 @@
+#!/Users/dheerajmurthy/miniforge3/envs/ns3/bin/python
+"""
+Build the ns3sim extension: the ns3_sim scenario library plus pybind11 bindings.
+
+    NS3_DIR=/path/to/ns-3.42 pip install ./python
+
+ns-3 must already be built (./ns3 build) with shared libraries. NS3_DIR
+defaults to the ns-3 tree this project sits in (scratch/my_project).
+"""
+
+import os
+import re
+from pathlib import Path
+
+from pybind11.setup_helpers import Pybind11Extension, build_ext
+from setuptools import setup
+
+HERE = Path(__file__).resolve().parent
+PROJECT_DIR = HERE.parent
+NS3_DIR = Path(os.environ.get("NS3_DIR", PROJECT_DIR.parent.parent))
+NS3_BUILD = NS3_DIR / "build"
+NS3_MODULES = ["core", "network", "internet", "point-to-point", "applications",
+               "mobility", "netanim", "flow-monitor", "traffic-control"]
+
+
+def ns3_library(module):
+    """Link name of an ns-3 module library, e.g. ns3.42-core-default."""
+    pattern = re.compile(rf"lib(ns3[\d.]*-{re.escape(module)}-[a-z]+)\.(so|dylib)$")
+    for lib in sorted((NS3_BUILD / "lib").iterdir()):
+        match = pattern.match(lib.name)
+        if match:
+            return match.group(1)
+    raise SystemExit(f"ns-3 library for module '{module}' not found in {NS3_BUILD / 'lib'}")
+
+
+# Everything but ns3_sim.cc, which holds the command-line main()
+sources = [str(HERE / "ns3sim_module.cc")] + [
+    str(p) for p in sorted(PROJECT_DIR.glob("*.cc")) if p.name != "ns3_sim.cc"
+]
+
+ext = Pybind11Extension(
+    "ns3sim",
+    sources,
+    include_dirs=[str(NS3_BUILD / "include"), str(PROJECT_DIR)],
+    library_dirs=[str(NS3_BUILD / "lib")],
+    runtime_library_dirs=[str(NS3_BUILD / "lib")],
+    libraries=[ns3_library(m) for m in NS3_MODULES],
+    # Match the default ns-3 build profile
+    define_macros=[("NS3_LOG_ENABLE", None), ("NS3_ASSERT_ENABLE", None)],
+    cxx_std=17,
+)
+
+setup(
+    name="ns3sim",
+    version="0.1",
+    description="In-process ns3_sim scenarios with NumPy results",
+    ext_modules=[ext],
+    py_modules=["ns3_env"],
+    cmdclass={"build_ext": build_ext},
+    install_requires=["numpy"],
+)
@@ -0,0 +1,69 @@
+#include "route-log.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+RouteLog::RouteLog(const std::string& file, double start, double stop)
+    : m_out(file),
+      m_start(start),
+      m_stop(stop)
+{
+    if (!m_out)
+    {
+        std::cerr << "Cannot write route log " << file << "\n";
+        return;
+    }
+    m_out << "time_s,node,op,dest,gateway,iface,cause\n";
+}
+
+bool
+RouteLog::IsOpen() const
+{
+    return m_out.is_open() && m_out.good();
+}
+
+void
+RouteLog::Added(uint32_t node,
+                Ipv4Address dest,
+                Ipv4Address gateway,
+                uint32_t iface,
+                const char* cause)
+{
+    Write('+', node, dest, gateway, iface, cause);
+}
+
+void
+RouteLog::Removed(uint32_t node,
+                  Ipv4Address dest,
+                  Ipv4Address gateway,
+                  uint32_t iface,
+                  const char* cause)
+{
+    Write('-', node, dest, gateway, iface, cause);
+}
+
+uint64_t
+RouteLog::GetRows() const
+{
+    return m_rows;
+}
+
+void
+RouteLog::Write(char op,
+                uint32_t node,
+                Ipv4Address dest,
+                Ipv4Address gateway,
+                uint32_t iface,
+                const char* cause)
+{
+    double now = Simulator::Now().GetSeconds();
+    if (!IsOpen() || now < m_start || (m_stop > 0.0 && now > m_stop))
+        return;
+    m_out << now << "," << node << "," << op << ",";
+    dest.Print(m_out);
+    m_out << ",";
+    gateway.Print(m_out);
+    m_out << "," << iface << "," << cause << "\n";
+    m_rows++;
+}
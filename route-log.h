@@ -0,0 +1,53 @@
+#ifndef ROUTE_LOG_H
+#define ROUTE_LOG_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// Host route changes made while the simulation runs, one CSV row per change:
+//   time_s,node,op,dest,gateway,iface,cause
+// op is + (added) or - (removed); cause is repair or restore (link events)
+// or agent (StepEnvironment). Routes installed at setup (routing.json, global
+// routing) are not repeated, so the file stays proportional to the number of
+// changes instead of the table size, unlike NetAnim's periodic route dumps.
+class RouteLog
+{
+  public:
+    // Only changes within [start, stop] s are written; stop <= 0 = end of run.
+    RouteLog(const std::string& file, double start, double stop);
+
+    bool IsOpen() const;
+
+    void Added(uint32_t node,
+               ns3::Ipv4Address dest,
+               ns3::Ipv4Address gateway,
+               uint32_t iface,
+               const char* cause);
+    void Removed(uint32_t node,
+                 ns3::Ipv4Address dest,
+                 ns3::Ipv4Address gateway,
+                 uint32_t iface,
+                 const char* cause);
+
+    // Rows written so far
+    uint64_t GetRows() const;
+
+  private:
+    void Write(char op,
+               uint32_t node,
+               ns3::Ipv4Address dest,
+               ns3::Ipv4Address gateway,
+               uint32_t iface,
+               const char* cause);
+
+    std::ofstream m_out;
+    double m_start;
+    double m_stop;
+    uint64_t m_rows = 0;
+};
+
+#endif // ROUTE_LOG_H
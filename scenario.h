@@ -0,0 +1,235 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "convergence-monitor.h"
+#include "flow-windows.h"
+#include "link-events.h"
+#include "link-queues.h"
+#include "topology-import.h"
+#include "topology-spec.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Seed-independent state produced by the setup phase (nodes, stacks, devices,
+// addresses and static routes). In fork mode it is built once and shared
+// copy-on-write by every traffic child.
+struct SimTopology
+{
+    uint32_t nNodes = 0;
+    ns3::NodeContainer nodes;
+    std::vector<ns3::NetDeviceContainer> linkDevs; // per topology.json link
+    std::vector<std::vector<std::string>> nodeIpv4Strings;
+    std::vector<std::pair<uint32_t, uint32_t>> flowPairs;
+    // routing.json demand (Mbps) of each route of a pair, in file order
+    std::map<std::pair<uint32_t, uint32_t>, std::vector<double>> demands;
+    // routing.json path of each route of a pair, in file order
+    std::map<std::pair<uint32_t, uint32_t>, std::vector<std::vector<uint32_t>>> routePaths;
+    // --routing=source: SourceRouteTable path of each route of a pair, in
+    // file order; UINT32_MAX where the route has no usable path
+    std::map<std::pair<uint32_t, uint32_t>, std::vector<uint32_t>> sourcePaths;
+    std::shared_ptr<LinkEventManager> linkEvents;
+};
+
+// Per-run traffic parameters and output files.
+struct RunConfig
+{
+    uint32_t nFlows = 50;
+    bool fastMode = false;
+    double maxTime = 42.0;
+    bool autoStop = false;
+    ConvergenceMonitor::Params convergence;
+    bool crn = false;            // common random numbers for traffic
+    double warmup = 0.0;         // measurement starts here; 0 = whole run
+    double windowInterval = 0.0; // per-window table granularity; 0 = one window
+    bool anim = true;                        // NetAnim output unless fastMode
+    std::string metricsFile = "metrics.csv"; // empty = do not write
+    std::string animFile = "sim-anim.xml";
+    std::string routesFile = "routes.xml";
+    std::string flowmonFile = "flowmon-results.xml";
+    std::string windowsFile = "windows.csv";
+    std::string eventsFile = "link-events.csv";
+    std::string pathsFile = "paths.csv";
+    std::string pathReportFile = "path-report.csv";
+    std::string dropsFile = "drops.csv";
+    std::string mode = "packet";    // packet (ns-3) or fluid (FluidModel)
+    std::string routing = "static"; // routing.json routes: static, flat or source
+    bool lean = false;              // IPv4/UDP only, no mobility without NetAnim
+    uint32_t trainLength = 1;       // >1: packets per send event (PacketTrainApplication)
+    bool useDemand = false;         // offer each route's routing.json demand
+    double loadScale = 1.0;         // multiplies every flow's offered rate
+    uint32_t pathTrace = 0;         // >0: record the path of 1 in N packets per flow
+    bool drops = false;             // count drops by reason per link, node and flow
+    std::string envSocket;          // non-empty: step-wise agent control (StepEnvironment)
+    double envStep = 0.1;           // simulated seconds between agent steps
+    uint32_t envMaxActions = 1024;  // route updates the agent may send per step
+    int envSlot = -1;               // >=0: EnvPool worker slot in envSocket + ".shm"
+    int envFd = -1;                 // ... and the worker's end of its pool socket
+    std::string scheduler = "map";  // event scheduler: map, heap, calendar, list or ladder
+    std::string schedTraceFile;     // non-empty: record scheduler operations for --schedBench
+    std::string routeLogFile;       // non-empty: log route changes (RouteLog), no routes.xml
+    double routeLogStart = 0.0;     // route changes logged from here (s) ...
+    double routeLogStop = 0.0;      // ... to here; 0 = end of run
+    QueueDefaults queues;
+
+    // Turn off NetAnim and every per-run output file, for drivers that run
+    // many simulations and callers that take results in memory.
+    void DisableFileOutput()
+    {
+        anim = false;
+        metricsFile.clear();
+        flowmonFile.clear();
+        windowsFile.clear();
+        eventsFile.clear();
+        pathsFile.clear();
+        pathReportFile.clear();
+        dropsFile.clear();
+        routeLogFile.clear();
+    }
+};
+
+// Reported flows of one run, reduced for sweeps and replications.
+struct RunSummary
+{
+    uint32_t flows = 0;
+    double offeredMbps = 0.0;    // sum of configured flow rates
+    double throughputMbps = 0.0; // sum over flows
+    uint64_t txPackets = 0;
+    uint64_t rxPackets = 0;
+    double worstThroughput = 0.0; // lowest per-flow throughput (Mbps)
+    int worstSrc = -1;
+    int worstDst = -1;
+    std::map<double, uint64_t> delayBins; // FlowMonitor delay bin end (s) -> packets
+
+    double LossPct() const
+    {
+        return txPackets > 0 ? (double(txPackets) - rxPackets) / txPackets * 100.0 : 0.0;
+    }
+
+    // Upper edge of the delay bin holding the 99th percentile packet; NaN if
+    // no delay histogram was collected.
+    double P99DelayMs() const
+    {
+        uint64_t total = 0;
+        for (auto& kv : delayBins)
+            total += kv.second;
+        uint64_t seen = 0;
+        for (auto& kv : delayBins)
+        {
+            seen += kv.second;
+            if (seen * 100 >= total * 99)
+                return kv.first * 1000.0;
+        }
+        return NAN;
+    }
+};
+
+
+// Per-flow results of one run in column form (the metrics.csv columns), so
+// bindings can expose each column as an array without copying.
+struct FlowResults
+{
+    std::vector<uint32_t> flowId;
+    std::vector<int32_t> src;
+    std::vector<int32_t> dst;
+    std::vector<uint32_t> txPackets;
+    std::vector<uint32_t> rxPackets;
+    std::vector<uint64_t> txBytes;
+    std::vector<uint64_t> rxBytes;
+    std::vector<double> throughputMbps;
+    std::vector<double> delayMs;
+    std::vector<double> lossPct;
+
+    void Add(uint32_t id, int32_t srcIdx, int32_t dstIdx, const FlowCounters& c, double duration);
+    size_t Size() const;
+};
+
+// Create nodes, links, addresses and routes for `links`. routing.json host
+// routes are installed over global routing; a LinkEventManager is attached if
+// there are `events` or `linkEvents` is set.
+void BuildTopology(SimTopology& sim,
+                   const std::vector<LinkSpec>& links,
+                   const std::vector<RouteSpec>& routes,
+                   const std::vector<LinkEvent>& events,
+                   const RunConfig& cfg,
+                   bool linkEvents);
+
+// Install traffic for the current RNG run, simulate, and write the outputs
+// named in `cfg`. `summary` and `results` receive the reported flows.
+// Ends with Simulator::Destroy(), so `sim` must be rebuilt for the next run
+// unless it is shared with forked children.
+int RunTraffic(SimTopology& sim,
+               const RunConfig& cfg,
+               RunSummary* summary = nullptr,
+               FlowResults* results = nullptr);
+
+// Flow-level evaluation with the same inputs and metrics.csv schema. The k-th
+// flow of a pair follows the k-th routing.json path of that pair, as in
+// RunTraffic.
+int RunFluid(const SimTopology& sim,
+             const std::vector<LinkSpec>& links,
+             const RunConfig& cfg,
+             RunSummary* summary = nullptr,
+             FlowResults* results = nullptr);
+
+// Load, build, run and collect one ns3_sim scenario in-process. Each Run()
+// consumes the built network (the simulator is destroyed afterwards), so the
+// next Run() rebuilds it; change routes or config in between to evaluate
+// candidates in a loop.
+class Scenario
+{
+  public:
+    // Read topology.json and, if it exists, routing.json.
+    bool Load(const std::string& topoFile, const std::string& routeFile = "");
+    // Generate a synthetic topology from a --gen spec (GenerateTopology)
+    // instead of reading topology.json; routes as for Load().
+    bool Generate(const std::string& spec, const std::string& routeFile = "");
+    // Read a GraphML or Rocketfuel topology (ImportTopology); routes as for Load().
+    bool Import(const std::string& file,
+                const ImportOptions& opts,
+                const std::string& routeFile = "");
+    // Replace the routes (and the routing.json flow pairs) used by the next build.
+    void SetRoutes(const std::vector<RouteSpec>& routes);
+
+    RunConfig& Config();
+    const std::vector<LinkSpec>& GetLinks() const;
+    const std::vector<LinkEvent>& GetEvents() const;
+    const std::vector<RouteSpec>& GetRoutes() const;
+
+    // Build the packet-level network now (Run() does it on demand).
+    void Build(bool linkEvents = false);
+    bool IsBuilt() const;
+    // Setup state for drivers that fork children off a built network.
+    SimTopology& GetTopology();
+
+    // Simulate with Config(); returns 0 on success.
+    int Run();
+
+    const RunSummary& GetSummary() const;
+    // Results of the last Run(); stays valid after later runs.
+    std::shared_ptr<const FlowResults> GetResults() const;
+
+  private:
+    uint32_t m_nNodes = 0;
+    std::vector<LinkSpec> m_links;
+    std::vector<LinkEvent> m_events;
+    std::vector<RouteSpec> m_routes;
+    std::vector<std::pair<uint32_t, uint32_t>> m_flowPairs;
+    std::map<std::pair<uint32_t, uint32_t>, std::vector<double>> m_demands;
+    std::map<std::pair<uint32_t, uint32_t>, std::vector<std::vector<uint32_t>>> m_routePaths;
+    RunConfig m_cfg;
+    SimTopology m_sim;
+    bool m_built = false;
+    RunSummary m_summary;
+    std::shared_ptr<FlowResults> m_results;
+};
+
+#endif // SCENARIO_H
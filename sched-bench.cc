@@ -0,0 +1,223 @@
+#include "sched-bench.h"
+
+#include "sim-trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("SchedBench");
+
+NS_OBJECT_ENSURE_REGISTERED(RecordingScheduler);
+
+namespace
+{
+
+struct SchedRecord
+{
+    uint64_t ts;
+    uint32_t uid;
+    uint32_t op;
+};
+
+static_assert(sizeof(SchedRecord) == 16, "Trace records are 16 bytes");
+
+const std::pair<const char*, const char*> kSchedulers[] = {
+    {"map", "ns3::MapScheduler"},
+    {"heap", "ns3::HeapScheduler"},
+    {"calendar", "ns3::CalendarScheduler"},
+    {"list", "ns3::ListScheduler"},
+    {"ladder", "ns3::LadderScheduler"},
+};
+
+} // namespace
+
+std::string
+SchedulerTypeName(const std::string& name)
+{
+    for (const auto& s : kSchedulers)
+    {
+        if (name == s.first)
+            return s.second;
+    }
+    return "";
+}
+
+void
+SelectScheduler(const std::string& name, const std::string& traceFile)
+{
+    ObjectFactory factory;
+    if (SimTrace::Active())
+    {
+        factory.SetTypeId("ns3::TracingScheduler");
+        factory.Set("Inner", StringValue(SchedulerTypeName(name)));
+    }
+    else if (traceFile.empty())
+    {
+        factory.SetTypeId(SchedulerTypeName(name));
+    }
+    else
+    {
+        factory.SetTypeId("ns3::RecordingScheduler");
+        factory.Set("Inner", StringValue(SchedulerTypeName(name)));
+        factory.Set("File", StringValue(traceFile));
+    }
+    Simulator::SetScheduler(factory);
+}
+
+TypeId
+RecordingScheduler::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::RecordingScheduler")
+                            .SetParent<Scheduler>()
+                            .SetGroupName("Core")
+                            .AddConstructor<RecordingScheduler>()
+                            .AddAttribute("Inner",
+                                          "TypeId name of the scheduler that holds the events",
+                                          StringValue("ns3::MapScheduler"),
+                                          MakeStringAccessor(&RecordingScheduler::SetInner),
+                                          MakeStringChecker())
+                            .AddAttribute("File",
+                                          "Trace output file",
+                                          StringValue(""),
+                                          MakeStringAccessor(&RecordingScheduler::SetFile),
+                                          MakeStringChecker());
+    return tid;
+}
+
+void
+RecordingScheduler::SetInner(std::string type)
+{
+    m_inner = ObjectFactory(type).Create<Scheduler>();
+}
+
+void
+RecordingScheduler::SetFile(std::string file)
+{
+    if (m_out.is_open())
+        m_out.close();
+    if (!file.empty())
+        m_out.open(file, std::ios::binary | std::ios::trunc);
+}
+
+void
+RecordingScheduler::Record(const Event& ev, char op)
+{
+    SchedRecord r{ev.key.m_ts, ev.key.m_uid, uint32_t(op)};
+    m_out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+}
+
+void
+RecordingScheduler::Insert(const Event& ev)
+{
+    Record(ev, 'I');
+    m_inner->Insert(ev);
+}
+
+bool
+RecordingScheduler::IsEmpty() const
+{
+    return m_inner->IsEmpty();
+}
+
+Scheduler::Event
+RecordingScheduler::PeekNext() const
+{
+    return m_inner->PeekNext();
+}
+
+Scheduler::Event
+RecordingScheduler::RemoveNext()
+{
+    Event ev = m_inner->RemoveNext();
+    Record(ev, 'N');
+    return ev;
+}
+
+void
+RecordingScheduler::Remove(const Event& ev)
+{
+    Record(ev, 'R');
+    m_inner->Remove(ev);
+}
+
+int
+BenchmarkSchedulers(const std::string& traceFile, const std::string& outFile)
+{
+    // Load the whole trace first so the timings exclude file I/O
+    std::ifstream in(traceFile, std::ios::binary);
+    if (!in)
+    {
+        std::cerr << "Cannot open scheduler trace " << traceFile << "\n";
+        return 1;
+    }
+    in.seekg(0, std::ios::end);
+    size_t bytes = size_t(in.tellg());
+    std::vector<SchedRecord> trace(bytes / sizeof(SchedRecord));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(trace.data()), trace.size() * sizeof(SchedRecord));
+    if (!in || bytes % sizeof(SchedRecord) != 0)
+    {
+        std::cerr << "Truncated or unreadable scheduler trace " << traceFile << "\n";
+        return 1;
+    }
+    // Replaying a damaged trace would take from an empty scheduler
+    size_t maxPending = 0;
+    size_t pending = 0;
+    for (size_t i = 0; i < trace.size(); ++i)
+    {
+        const SchedRecord& r = trace[i];
+        if ((r.op != 'I' && r.op != 'N' && r.op != 'R') || (r.op != 'I' && pending == 0))
+        {
+            std::cerr << "Invalid scheduler trace " << traceFile << " at record " << i << "\n";
+            return 1;
+        }
+        pending += r.op == 'I' ? 1 : -1;
+        maxPending = std::max(maxPending, pending);
+    }
+    NS_LOG_UNCOND("[SCHED] " << trace.size() << " operations from " << traceFile << ", up to "
+                             << maxPending << " pending events");
+
+    std::ofstream out(outFile);
+    out << "scheduler,operations,max_pending,seconds,ns_per_op,mismatches\n";
+    int rc = 0;
+    for (const auto& s : kSchedulers)
+    {
+        Ptr<Scheduler> scheduler = ObjectFactory(s.second).Create<Scheduler>();
+        uint64_t mismatches = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (const SchedRecord& r : trace)
+        {
+            Scheduler::Event ev{nullptr, {r.ts, r.uid, 0}};
+            switch (r.op)
+            {
+            case 'I':
+                scheduler->Insert(ev);
+                break;
+            case 'N':
+                // The simulator peeks at the next event before taking it
+                scheduler->PeekNext();
+                mismatches += scheduler->RemoveNext().key.m_uid != r.uid;
+                break;
+            default:
+                scheduler->Remove(ev);
+                break;
+            }
+        }
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        double nsPerOp = trace.empty() ? 0.0 : seconds * 1e9 / trace.size();
+        out << s.first << "," << trace.size() << "," << maxPending << "," << seconds << ","
+            << nsPerOp << "," << mismatches << "\n";
+        NS_LOG_UNCOND("[SCHED] " << s.first << ": " << nsPerOp << " ns/op"
+                                 << (mismatches ? ", ORDER MISMATCH" : ""));
+        if (mismatches)
+            rc = 1;
+    }
+    NS_LOG_UNCOND("[SCHED] → " << outFile);
+    return rc;
+}
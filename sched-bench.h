@@ -0,0 +1,47 @@
+#ifndef SCHED_BENCH_H
+#define SCHED_BENCH_H
+
+#include "ns3/core-module.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// ns-3 TypeId name for a --scheduler choice (map, heap, calendar, list,
+// ladder), or "" if there is none.
+std::string SchedulerTypeName(const std::string& name);
+
+// Make the simulator use scheduler `name`. With a `traceFile`, every queue
+// operation is also recorded there for --schedBench; while a SimTrace is
+// active, events are profiled instead (TracingScheduler).
+void SelectScheduler(const std::string& name, const std::string& traceFile);
+
+// Replay a recorded trace against every scheduler and write one CSV row per
+// scheduler. Returns non-zero if a scheduler dequeued a different event than
+// the recorded run, or the trace cannot be read.
+int BenchmarkSchedulers(const std::string& traceFile, const std::string& outFile);
+
+// Forwards to an inner scheduler and appends each operation to a trace of
+// 16-byte records in native byte order: uint64 timestamp, uint32 event uid,
+// uint32 operation ('I' insert, 'N' remove next, 'R' remove).
+class RecordingScheduler : public ns3::Scheduler
+{
+  public:
+    static ns3::TypeId GetTypeId();
+
+    void Insert(const Event& ev) override;
+    bool IsEmpty() const override;
+    Event PeekNext() const override;
+    Event RemoveNext() override;
+    void Remove(const Event& ev) override;
+
+  private:
+    void SetInner(std::string type);
+    void SetFile(std::string file);
+    void Record(const Event& ev, char op);
+
+    ns3::Ptr<ns3::Scheduler> m_inner;
+    std::ofstream m_out;
+};
+
+#endif // SCHED_BENCH_H
@@ -0,0 +1,92 @@
+#!/Users/dheerajmurthy/miniforge3/envs/ns3/bin/python
+"""
+Paired per-flow comparison of routing models run with --crn=1.
+Flows in model_results/*/metrics.csv are matched on (src_idx, dst_idx, occurrence),
+so each model is compared with the baseline on identical traffic.
+"""
+
+import csv
+import math
+import statistics
+import sys
+from collections import defaultdict
+from pathlib import Path
+
+# Configuration
+PROJECT_PATH = "/Users/dheerajmurthy/Downloads/IIITB/sem6/NHPC/project/simulation/ns-allinone-3.42/ns-3.42/scratch/my_project"
+RESULTS_DIR = Path(PROJECT_PATH) / "model_results"
+METRICS = ['throughput_mbps', 'avg_delay_ms', 'loss_pct']
+
+# Two-sided 97.5% Student t quantiles; normal approximation beyond 30 df
+T975 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042]
+
+
+def load_flows(csv_file):
+    """Key each flow by (src_idx, dst_idx, k) where k counts repeats of the pair."""
+    flows = {}
+    seen = defaultdict(int)
+    with open(csv_file, 'r') as f:
+        for row in csv.DictReader(f):
+            pair = (int(row['src_idx']), int(row['dst_idx']))
+            flows[pair + (seen[pair],)] = row
+            seen[pair] += 1
+    return flows
+
+
+def paired_interval(deltas):
+    """Mean paired difference and its 95% CI half-width."""
+    n = len(deltas)
+    mean = statistics.mean(deltas)
+    if n < 2:
+        return mean, float('nan')
+    t = T975[n - 2] if n - 1 <= len(T975) else 1.96
+    return mean, t * statistics.stdev(deltas) / math.sqrt(n)
+
+
+def main():
+    baseline = sys.argv[1] if len(sys.argv) > 1 else 'load_balanced_sp'
+    base_csv = RESULTS_DIR / baseline / "metrics.csv"
+    if not base_csv.exists():
+        print(f"Baseline metrics not found: {base_csv}")
+        return 1
+    base = load_flows(base_csv)
+
+    out_file = RESULTS_DIR / "paired_deltas.csv"
+    with open(out_file, 'w', newline='') as f:
+        writer = csv.writer(f)
+        writer.writerow(['model', 'src_idx', 'dst_idx', 'occurrence'] +
+                        [f"delta_{m}" for m in METRICS])
+
+        print(f"Paired deltas against {baseline} (model - baseline, 95% CI)")
+        for model_dir in sorted(RESULTS_DIR.iterdir()):
+            csv_file = model_dir / "metrics.csv"
+            if model_dir.name == baseline or not csv_file.exists():
+                continue
+            flows = load_flows(csv_file)
+            common = sorted(set(base) & set(flows))
+            if not common:
+                print(f"  {model_dir.name}: no matching flows")
+                continue
+
+            deltas = {m: [] for m in METRICS}
+            for key in common:
+                row = [float(flows[key][m]) - float(base[key][m]) for m in METRICS]
+                writer.writerow([model_dir.name, *key] + row)
+                for m, d in zip(METRICS, row):
+                    deltas[m].append(d)
+
+            unmatched = len(set(base) ^ set(flows))
+            print(f"  {model_dir.name}: {len(common)} paired flows"
+                  + (f" ({unmatched} unmatched)" if unmatched else ""))
+            for m in METRICS:
+                mean, hw = paired_interval(deltas[m])
+                print(f"    {m:16s} {mean:+10.4f} +/- {hw:.4f}")
+
+    print(f"Per-flow deltas written to {out_file}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,48 @@
+// Only this file's probes have semaphores: with them, sys/sdt.h makes every
+// probe in the translation unit refer to one.
+#define _SDT_HAS_SEMAPHORES 1
+#include "sim-probes.h"
+
+using namespace ns3;
+
+#if SIM_PROBES_ENABLED
+// Bumped by the tracer while attached; the names are fixed by sys/sdt.h.
+__extension__ unsigned short ns3sim_packet_send_semaphore __attribute__((unused))
+__attribute__((section(".probes")));
+__extension__ unsigned short ns3sim_packet_recv_semaphore __attribute__((unused))
+__attribute__((section(".probes")));
+
+#define NS3SIM_PACKET_SEND_ENABLED() __builtin_expect(ns3sim_packet_send_semaphore, 0)
+#define NS3SIM_PACKET_RECV_ENABLED() __builtin_expect(ns3sim_packet_recv_semaphore, 0)
+
+void
+ConnectPacketProbes(Ptr<Application> app,
+                    Ptr<PacketSink> sink,
+                    uint32_t flow,
+                    uint32_t src,
+                    uint32_t dst)
+{
+    if (NS3SIM_PACKET_SEND_ENABLED())
+    {
+        app->TraceConnectWithoutContext(
+            "Tx",
+            Callback<void, Ptr<const Packet>>([flow, src](Ptr<const Packet> p) {
+                SIM_PROBE4(packet_send, flow, src, p->GetUid(), p->GetSize());
+            }));
+    }
+    if (NS3SIM_PACKET_RECV_ENABLED())
+    {
+        sink->TraceConnectWithoutContext(
+            "Rx",
+            Callback<void, Ptr<const Packet>, const Address&>(
+                [flow, dst](Ptr<const Packet> p, const Address&) {
+                    SIM_PROBE4(packet_recv, flow, dst, p->GetUid(), p->GetSize());
+                }));
+    }
+}
+#else
+void
+ConnectPacketProbes(Ptr<Application>, Ptr<PacketSink>, uint32_t, uint32_t, uint32_t)
+{
+}
+#endif
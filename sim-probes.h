@@ -0,0 +1,67 @@
+#ifndef SIM_PROBES_H
+#define SIM_PROBES_H
+
+// USDT (SystemTap/DTrace-style) static probes under provider "ns3sim". With
+// <sys/sdt.h> available (systemtap-sdt-dev / systemtap-sdt-devel) each probe
+// compiles to a single nop plus an ELF note, so an idle probe costs nothing
+// and tools attach to the running binary:
+//
+//   bpftrace -l 'usdt:./ns3_sim:ns3sim:*'
+//   bpftrace -e 'usdt:./ns3_sim:ns3sim:flow_create { @[arg1] = count(); }' -p PID
+//   perf probe -x ./ns3_sim sdt_ns3sim:phase_end
+//
+// Without the header, or built with -DNS3SIM_NO_PROBES, the probes vanish and
+// SIM_PROBES_ENABLED is 0. packet_send/packet_recv need per-packet trace
+// callbacks, so they have semaphores and ConnectPacketProbes hooks a flow
+// only if a tool is attached to them when the flow is installed (e.g. a
+// bpftrace that starts the run with -c). Arguments (strings are char*):
+//
+//   phase_begin   name                         setup/run phase starts (TraceSpan)
+//   phase_end     name, wall_ns                ... ends, with its wall-clock length
+//   flow_create   flow, src, dst, rate_bps, start_ns
+//                                              traffic flow installed (RunTraffic)
+//   route_add     node, dest, gateway, iface, cause
+//   route_del     node, dest, gateway, iface, cause
+//                 host route installed or removed; addresses are uint32 in host
+//                 byte order; cause is setup, repair, restore or agent
+//   packet_send   flow, node, uid, bytes       traffic app sent a packet
+//   packet_recv   flow, node, uid, bytes       flow's sink received a packet
+//   metrics_row   flow, src, dst, tx_packets, rx_packets
+//                                              one metrics.csv or windows.csv row
+//   metrics_done  path, rows                   metrics.csv written and closed
+//
+// flow is the flow index (destination port - 9000) except in metrics_row,
+// which uses the FlowMonitor flow id; node, src and dst are node indices.
+
+#if !defined(NS3SIM_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SIM_PROBES_ENABLED 1
+#define SIM_PROBE1(name, a) DTRACE_PROBE1(ns3sim, name, a)
+#define SIM_PROBE2(name, a, b) DTRACE_PROBE2(ns3sim, name, a, b)
+#define SIM_PROBE4(name, a, b, c, d) DTRACE_PROBE4(ns3sim, name, a, b, c, d)
+#define SIM_PROBE5(name, a, b, c, d, e) DTRACE_PROBE5(ns3sim, name, a, b, c, d, e)
+#endif
+#endif
+
+#ifndef SIM_PROBES_ENABLED
+#define SIM_PROBES_ENABLED 0
+#define SIM_PROBE1(name, a) ((void)0)
+#define SIM_PROBE2(name, a, b) ((void)0)
+#define SIM_PROBE4(name, a, b, c, d) ((void)0)
+#define SIM_PROBE5(name, a, b, c, d, e) ((void)0)
+#endif
+
+#include "ns3/applications-module.h"
+
+#include <cstdint>
+
+// Fire packet_send for `app`'s Tx and packet_recv for `sink`'s Rx, if a tool
+// is attached to either probe; otherwise the flow gets no callbacks.
+void ConnectPacketProbes(ns3::Ptr<ns3::Application> app,
+                         ns3::Ptr<ns3::PacketSink> sink,
+                         uint32_t flow,
+                         uint32_t src,
+                         uint32_t dst);
+
+#endif // SIM_PROBES_H
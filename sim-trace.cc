@@ -0,0 +1,516 @@
+#include "sim-trace.h"
+
+#include "sim-probes.h"
+
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("SimTrace");
+
+NS_OBJECT_ENSURE_REGISTERED(TracingScheduler);
+
+namespace
+{
+
+SimTrace* g_active = nullptr;
+
+// Scheduler counters are sampled every this many events
+const uint64_t kCounterEvery = 4096;
+
+const char* const kStageNames[SimTrace::N_STAGES] =
+    {"send", "enqueue", "tx", "rx", "forward", "deliver"};
+
+// Takes the place of a sampled event in the simulator and times its callback.
+// The simulator releases the wrapper after the callback; the wrapper then
+// drops the scheduler's reference to the original event. Released wrappers
+// go on a free list, so sampling allocates only as many as are ever in
+// flight at once (one, as each is invoked right after RemoveNext).
+class TimedEvent : public EventImpl
+{
+  public:
+    TimedEvent(EventImpl* inner, uint32_t type)
+        : m_inner(inner),
+          m_type(type)
+    {
+    }
+
+    ~TimedEvent() override
+    {
+        m_inner->Unref();
+    }
+
+    static void* operator new(size_t size)
+    {
+        if (!s_free)
+            return ::operator new(size);
+        void* p = s_free;
+        s_free = *static_cast<void**>(p);
+        return p;
+    }
+
+    static void operator delete(void* p)
+    {
+        *static_cast<void**>(p) = s_free;
+        s_free = p;
+    }
+
+  protected:
+    void Notify() override
+    {
+        SimTrace* trace = SimTrace::Active();
+        if (!trace || m_inner->IsCancelled())
+        {
+            m_inner->Invoke();
+            return;
+        }
+        uint64_t begin = trace->NowNs();
+        m_inner->Invoke();
+        trace->EventSpan(m_type, begin, trace->NowNs());
+    }
+
+  private:
+    static void* s_free;
+
+    EventImpl* m_inner;
+    uint32_t m_type;
+};
+
+void* TimedEvent::s_free = nullptr;
+
+// MakeEvent instantiations are named after the member function pointer they
+// hold, e.g. "PointToPointNetDevice::*(Ptr<Packet>)"; anything else keeps
+// its demangled name, cut to a readable length.
+std::string
+EventTypeName(const std::type_index& type)
+{
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    std::string name = status == 0 && demangled ? demangled : type.name();
+    std::free(demangled);
+    for (size_t pos; (pos = name.find("ns3::")) != std::string::npos;)
+        name.erase(pos, 5);
+
+    size_t member = name.find("::*)");
+    size_t open = member == std::string::npos ? member : name.rfind('(', member);
+    if (open != std::string::npos)
+    {
+        size_t args = member + 4;
+        size_t end = args;
+        for (int depth = 0; end < name.size(); ++end)
+        {
+            depth += name[end] == '(' ? 1 : name[end] == ')' ? -1 : 0;
+            if (depth == 0)
+                break;
+        }
+        return name.substr(open + 1, member - open + 2) + name.substr(args, end - args + 1);
+    }
+    return name.size() > 80 ? name.substr(0, 77) + "..." : name;
+}
+
+// JSON string contents
+std::string
+Escape(const std::string& s)
+{
+    std::string out;
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+SimTrace::SimTrace(const Params& params)
+    : m_params(params),
+      m_start(std::chrono::steady_clock::now()),
+      m_records(new Record[params.capacity])
+{
+    m_params.eventSample = std::max<uint32_t>(m_params.eventSample, 1);
+    m_params.packetSample = std::max<uint32_t>(m_params.packetSample, 1);
+    g_active = this;
+}
+
+SimTrace::~SimTrace()
+{
+    if (g_active == this)
+        g_active = nullptr;
+}
+
+SimTrace*
+SimTrace::Active()
+{
+    return g_active;
+}
+
+const SimTrace::Params&
+SimTrace::GetParams() const
+{
+    return m_params;
+}
+
+uint64_t
+SimTrace::NowNs() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                m_start)
+        .count();
+}
+
+uint32_t
+SimTrace::Intern(const std::string& name)
+{
+    auto it = std::find(m_names.begin(), m_names.end(), name);
+    if (it != m_names.end())
+        return it - m_names.begin();
+    m_names.push_back(name);
+    return m_names.size() - 1;
+}
+
+void
+SimTrace::Append(const Record& r)
+{
+    size_t i = m_next.fetch_add(1, std::memory_order_relaxed);
+    if (i < m_params.capacity)
+        m_records[i] = r;
+}
+
+void
+SimTrace::Span(uint32_t name, uint64_t beginNs, uint64_t endNs)
+{
+    m_phases.push_back(Record{beginNs, endNs - beginNs, name, 0, PHASE, 0});
+}
+
+void
+SimTrace::Counter(uint32_t name, uint64_t value)
+{
+    Append(Record{NowNs(), value, name, 0, COUNTER, 0});
+}
+
+uint32_t
+SimTrace::CountEvent(const std::type_info& type)
+{
+    if (&type != m_lastType)
+    {
+        auto it = m_typeIndex.emplace(std::type_index(type), uint32_t(m_types.size()));
+        if (it.second)
+            m_types.push_back(EventType{std::type_index(type), 0, 0, 0});
+        m_lastType = &type;
+        m_lastIndex = it.first->second;
+    }
+    m_types[m_lastIndex].count++;
+    return m_lastIndex;
+}
+
+void
+SimTrace::EventSpan(uint32_t type, uint64_t beginNs, uint64_t endNs)
+{
+    m_types[type].sampled++;
+    m_types[type].sampledNs += endNs - beginNs;
+    Append(Record{beginNs, endNs - beginNs, type, 0, EVENT, 0});
+}
+
+void
+SimTrace::PacketStage(Stage stage, uint64_t uid, uint32_t node)
+{
+    Append(Record{uint64_t(Simulator::Now().GetNanoSeconds()), uid, stage, node, PACKET, 0});
+}
+
+bool
+SimTrace::Write(const std::string& file) const
+{
+    std::ofstream out(file);
+    if (!out)
+    {
+        std::cerr << "Cannot write trace " << file << "\n";
+        return false;
+    }
+    size_t n = std::min(m_next.load(), m_params.capacity);
+    std::vector<std::string> typeNames;
+    for (const EventType& t : m_types)
+        typeNames.push_back(EventTypeName(t.type));
+
+    auto meta = [&out](const char* what, int pid, int tid, const std::string& name) {
+        out << "{\"ph\":\"M\",\"pid\":" << pid;
+        if (tid)
+            out << ",\"tid\":" << tid;
+        out << ",\"name\":\"" << what << "\",\"args\":{\"name\":\"" << name << "\"}}";
+    };
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    meta("process_name", 1, 0, "wall clock");
+    out << ",\n";
+    meta("thread_name", 1, 1, "phases");
+    out << ",\n";
+    meta("thread_name", 1, 2, "events (1 in " + std::to_string(m_params.eventSample) + ")");
+    out << ",\n";
+    meta("process_name",
+         2,
+         0,
+         "simulated time, packets (1 in " + std::to_string(m_params.packetSample) + ")");
+
+    // Packets still open at the end were dropped or in flight
+    std::unordered_map<uint64_t, uint64_t> open;
+    for (size_t i = 0; i < m_phases.size() + n; ++i)
+    {
+        const Record& r = i < m_phases.size() ? m_phases[i] : m_records[i - m_phases.size()];
+        out << ",\n";
+        switch (r.kind)
+        {
+        case PHASE:
+        case EVENT:
+            out << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << (r.kind == PHASE ? 1 : 2) << ",\"name\":\""
+                << Escape(r.kind == PHASE ? m_names[r.name] : typeNames[r.name])
+                << "\",\"ts\":" << r.ts / 1e3 << ",\"dur\":" << r.arg / 1e3 << "}";
+            break;
+        case COUNTER:
+            out << "{\"ph\":\"C\",\"pid\":1,\"name\":\"" << Escape(m_names[r.name])
+                << "\",\"ts\":" << r.ts / 1e3 << ",\"args\":{\"value\":" << r.arg << "}}";
+            break;
+        case PACKET: {
+            const char* ph = r.name == SEND ? "b" : r.name == DELIVER ? "e" : "n";
+            if (r.name == SEND)
+                open[r.arg] = r.ts;
+            else if (r.name == DELIVER)
+                open.erase(r.arg);
+            else if (open.count(r.arg))
+                open[r.arg] = r.ts;
+            // Begin and end share the span's name; stages in between are named
+            const char* name = *ph == 'n' ? kStageNames[r.name] : "packet";
+            out << "{\"ph\":\"" << ph << "\",\"pid\":2,\"tid\":1,\"cat\":\"packet\",\"id\":"
+                << r.arg << ",\"name\":\"" << name << "\",\"ts\":" << r.ts / 1e3
+                << ",\"args\":{\"node\":" << r.node << ",\"stage\":\"" << kStageNames[r.name]
+                << "\"}}";
+            break;
+        }
+        }
+    }
+    for (const auto& kv : open)
+    {
+        out << ",\n{\"ph\":\"e\",\"pid\":2,\"tid\":1,\"cat\":\"packet\",\"id\":" << kv.first
+            << ",\"name\":\"packet\",\"ts\":" << kv.second / 1e3
+            << ",\"args\":{\"delivered\":false}}";
+    }
+    out << "\n],\n\"eventTypes\":[";
+
+    // Callback types by estimated total time
+    std::vector<uint32_t> order(m_types.size());
+    for (uint32_t t = 0; t < order.size(); ++t)
+        order[t] = t;
+    auto estimatedNs = [this](uint32_t t) {
+        const EventType& e = m_types[t];
+        return e.sampled ? double(e.sampledNs) / e.sampled * e.count : 0.0;
+    };
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return estimatedNs(a) > estimatedNs(b);
+    });
+    uint64_t events = 0;
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        const EventType& e = m_types[order[i]];
+        events += e.count;
+        out << (i ? ",\n" : "\n") << "{\"type\":\"" << Escape(typeNames[order[i]])
+            << "\",\"count\":" << e.count << ",\"sampled\":" << e.sampled
+            << ",\"sampled_ms\":" << e.sampledNs / 1e6
+            << ",\"estimated_ms\":" << estimatedNs(order[i]) / 1e6 << "}";
+    }
+    out << "\n],\n\"droppedRecords\":" << m_next.load() - n << "}\n";
+    if (!out)
+    {
+        std::cerr << "Cannot write trace " << file << "\n";
+        return false;
+    }
+
+    NS_LOG_UNCOND("[TRACE] " << m_phases.size() + n << " records, " << events << " events of "
+                             << m_types.size() << " callback types → " << file);
+    for (size_t i = 0; i < std::min<size_t>(order.size(), 5); ++i)
+    {
+        NS_LOG_UNCOND("[TRACE]   " << typeNames[order[i]] << ": " << m_types[order[i]].count
+                                  << " events, ~" << estimatedNs(order[i]) / 1e6 << " ms");
+    }
+    if (m_next.load() > n)
+    {
+        NS_LOG_UNCOND("[TRACE] Buffer full: " << m_next.load() - n
+                                              << " records dropped, raise --traceBuffer");
+    }
+    return true;
+}
+
+TraceSpan::TraceSpan(const char* name)
+    : m_name(name),
+      m_begin(std::chrono::steady_clock::now()),
+      m_trace(SimTrace::Active())
+{
+    SIM_PROBE1(phase_begin, name);
+    if (m_trace)
+    {
+        m_traceName = m_trace->Intern(name);
+        m_traceBegin = m_trace->NowNs();
+    }
+}
+
+TraceSpan::~TraceSpan()
+{
+    End();
+}
+
+void
+TraceSpan::End()
+{
+    if (!m_open)
+        return;
+    m_open = false;
+    SIM_PROBE2(phase_end,
+               m_name,
+               uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - m_begin)
+                            .count()));
+    if (m_trace)
+        m_trace->Span(m_traceName, m_traceBegin, m_trace->NowNs());
+}
+
+TypeId
+TracingScheduler::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::TracingScheduler")
+                            .SetParent<Scheduler>()
+                            .SetGroupName("Core")
+                            .AddConstructor<TracingScheduler>()
+                            .AddAttribute("Inner",
+                                          "TypeId name of the scheduler that holds the events",
+                                          StringValue("ns3::MapScheduler"),
+                                          MakeStringAccessor(&TracingScheduler::SetInner),
+                                          MakeStringChecker());
+    return tid;
+}
+
+TracingScheduler::TracingScheduler()
+{
+    // SelectScheduler installs this only while a SimTrace is active
+    if (SimTrace* trace = SimTrace::Active())
+    {
+        m_pendingName = trace->Intern("pending events");
+        m_simulatedName = trace->Intern("simulated ms");
+    }
+}
+
+void
+TracingScheduler::SetInner(std::string type)
+{
+    m_inner = ObjectFactory(type).Create<Scheduler>();
+}
+
+void
+TracingScheduler::Insert(const Event& ev)
+{
+    m_pending++;
+    m_inner->Insert(ev);
+}
+
+bool
+TracingScheduler::IsEmpty() const
+{
+    return m_inner->IsEmpty();
+}
+
+Scheduler::Event
+TracingScheduler::PeekNext() const
+{
+    return m_inner->PeekNext();
+}
+
+Scheduler::Event
+TracingScheduler::RemoveNext()
+{
+    Event ev = m_inner->RemoveNext();
+    m_pending--;
+    SimTrace* trace = SimTrace::Active();
+    if (!trace)
+        return ev;
+    uint32_t type = trace->CountEvent(typeid(*ev.impl));
+    if (++m_removed % trace->GetParams().eventSample == 0)
+        ev.impl = new TimedEvent(ev.impl, type);
+    if (m_removed % kCounterEvery == 0)
+    {
+        trace->Counter(m_pendingName, m_pending);
+        trace->Counter(m_simulatedName, Simulator::Now().GetMilliSeconds());
+    }
+    return ev;
+}
+
+void
+TracingScheduler::Remove(const Event& ev)
+{
+    m_pending--;
+    m_inner->Remove(ev);
+}
+
+PacketStageTracer::PacketStageTracer(const NodeContainer& nodes,
+                                     const std::vector<NetDeviceContainer>& linkDevs)
+    : m_trace(SimTrace::Active()),
+      m_sample(m_trace ? m_trace->GetParams().packetSample : 1)
+{
+    if (!m_trace)
+        return;
+    using Ipv4Trace = Callback<void, const Ipv4Header&, Ptr<const Packet>, uint32_t>;
+    using DeviceTrace = Callback<void, Ptr<const Packet>>;
+    std::map<Ptr<Node>, uint32_t> index;
+    for (uint32_t n = 0; n < nodes.GetN(); ++n)
+    {
+        index[nodes.Get(n)] = n;
+        Ptr<Ipv4L3Protocol> ipv4 = nodes.Get(n)->GetObject<Ipv4L3Protocol>();
+        const std::pair<const char*, SimTrace::Stage> hooks[] = {
+            {"SendOutgoing", SimTrace::SEND},
+            {"UnicastForward", SimTrace::FORWARD},
+            {"LocalDeliver", SimTrace::DELIVER},
+        };
+        for (const auto& h : hooks)
+        {
+            SimTrace::Stage stage = h.second;
+            ipv4->TraceConnectWithoutContext(
+                h.first,
+                Ipv4Trace([this, stage, n](const Ipv4Header&, Ptr<const Packet> p, uint32_t) {
+                    Observe(stage, p, n);
+                }));
+        }
+    }
+    for (const NetDeviceContainer& devs : linkDevs)
+    {
+        for (uint32_t side = 0; side < 2; ++side)
+        {
+            Ptr<NetDevice> dev = devs.Get(side);
+            uint32_t n = index[dev->GetNode()];
+            const std::pair<const char*, SimTrace::Stage> hooks[] = {
+                {"MacTx", SimTrace::ENQUEUE},
+                {"PhyTxBegin", SimTrace::TX},
+                {"PhyRxEnd", SimTrace::RX},
+            };
+            for (const auto& h : hooks)
+            {
+                SimTrace::Stage stage = h.second;
+                dev->TraceConnectWithoutContext(
+                    h.first,
+                    DeviceTrace([this, stage, n](Ptr<const Packet> p) { Observe(stage, p, n); }));
+            }
+        }
+    }
+}
+
+void
+PacketStageTracer::Observe(SimTrace::Stage stage, Ptr<const Packet> p, uint32_t node)
+{
+    if (p->GetUid() % m_sample == 0)
+        m_trace->PacketStage(stage, p->GetUid(), node);
+}
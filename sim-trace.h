@@ -0,0 +1,174 @@
+#ifndef SIM_TRACE_H
+#define SIM_TRACE_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+// Sampled profile of a run for chrome://tracing or ui.perfetto.dev (--trace).
+// Records go to a fixed-size buffer claimed with one atomic increment, and
+// recording stops when it is full; names are interned up front and timed
+// event wrappers recycled, so the hot paths never lock or allocate.
+// Phase spans are few and kept apart, so a full buffer never loses them.
+//
+// Wall-clock track (pid 1): nested setup/run phases, one span per sampled
+// event callback named after its type, and scheduler counters.
+// Simulated-time track (pid 2): each sampled packet as an async span from
+// SendOutgoing to LocalDeliver, with its enqueue/tx/rx/forward stages.
+// Every event is counted by callback type; cumulative times are estimated
+// from the sampled ones and listed under the trace's "eventTypes" key.
+class SimTrace
+{
+  public:
+    struct Params
+    {
+        uint32_t eventSample = 64;    // time 1 in N event callbacks
+        uint32_t packetSample = 1000; // follow packets whose uid is a multiple of N
+        size_t capacity = 1 << 20;    // records (32 bytes each)
+    };
+
+    enum Stage
+    {
+        SEND,
+        ENQUEUE,
+        TX,
+        RX,
+        FORWARD,
+        DELIVER,
+        N_STAGES
+    };
+
+    // Becomes Active() until destroyed.
+    explicit SimTrace(const Params& params);
+    ~SimTrace();
+
+    // The tracer of this process, or null when tracing is off.
+    static SimTrace* Active();
+
+    const Params& GetParams() const;
+    // Wall-clock ns since the tracer was created.
+    uint64_t NowNs() const;
+    // Index of a phase or counter name; not for hot paths.
+    uint32_t Intern(const std::string& name);
+
+    void Span(uint32_t name, uint64_t beginNs, uint64_t endNs);
+    void Counter(uint32_t name, uint64_t value);
+    // Index of an event callback type, counting one event of it.
+    uint32_t CountEvent(const std::type_info& type);
+    void EventSpan(uint32_t type, uint64_t beginNs, uint64_t endNs);
+    void PacketStage(Stage stage, uint64_t uid, uint32_t node);
+
+    // Write Chrome trace JSON. Prints an error and returns false on failure.
+    bool Write(const std::string& file) const;
+
+  private:
+    enum Kind : uint32_t
+    {
+        PHASE,
+        EVENT,
+        COUNTER,
+        PACKET
+    };
+
+    struct Record
+    {
+        uint64_t ts;   // wall-clock ns, or simulated ns for PACKET
+        uint64_t arg;  // span length (ns), counter value or packet uid
+        uint32_t name; // name index, event type or stage
+        uint32_t node; // PACKET only
+        Kind kind;
+        uint32_t pad;
+    };
+
+    struct EventType
+    {
+        std::type_index type;
+        uint64_t count;
+        uint64_t sampled;
+        uint64_t sampledNs;
+    };
+
+    void Append(const Record& r);
+
+    Params m_params;
+    std::chrono::steady_clock::time_point m_start;
+    std::unique_ptr<Record[]> m_records;
+    std::vector<Record> m_phases;
+    std::atomic<size_t> m_next{0};
+    std::vector<std::string> m_names;
+    std::vector<EventType> m_types;
+    std::unordered_map<std::type_index, uint32_t> m_typeIndex;
+    const std::type_info* m_lastType = nullptr; // most events repeat the previous type
+    uint32_t m_lastIndex = 0;
+};
+
+// Phase from construction to End() or destruction: fires the phase_begin
+// and phase_end probes, and is a span on the wall-clock track while tracing.
+class TraceSpan
+{
+  public:
+    explicit TraceSpan(const char* name);
+    ~TraceSpan();
+    void End();
+
+  private:
+    const char* m_name;
+    std::chrono::steady_clock::time_point m_begin;
+    bool m_open = true;
+    SimTrace* m_trace;
+    uint32_t m_traceName = 0;
+    uint64_t m_traceBegin = 0;
+};
+
+// Forwards to an inner scheduler (attribute Inner) and, as the simulator
+// takes each event, counts it by callback type; 1 in eventSample is wrapped
+// so that its callback is timed. Installed by SelectScheduler while a
+// SimTrace is active.
+class TracingScheduler : public ns3::Scheduler
+{
+  public:
+    static ns3::TypeId GetTypeId();
+
+    TracingScheduler();
+
+    void Insert(const Event& ev) override;
+    bool IsEmpty() const override;
+    Event PeekNext() const override;
+    Event RemoveNext() override;
+    void Remove(const Event& ev) override;
+
+  private:
+    void SetInner(std::string type);
+
+    ns3::Ptr<ns3::Scheduler> m_inner;
+    uint64_t m_removed = 0;
+    uint64_t m_pending = 0;
+    uint32_t m_pendingName = 0;
+    uint32_t m_simulatedName = 0;
+};
+
+// Follows sampled packets through the Ipv4L3Protocol traces of every node
+// and the point-to-point device traces of every link.
+class PacketStageTracer
+{
+  public:
+    // `linkDevs[k]` are the devices of link k (src side first).
+    PacketStageTracer(const ns3::NodeContainer& nodes,
+                      const std::vector<ns3::NetDeviceContainer>& linkDevs);
+
+  private:
+    void Observe(SimTrace::Stage stage, ns3::Ptr<const ns3::Packet> p, uint32_t node);
+
+    SimTrace* m_trace;
+    uint32_t m_sample;
+};
+
+#endif // SIM_TRACE_H
@@ -0,0 +1,296 @@
+#include "source-routing.h"
+
+#include <algorithm>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("SourceRouting");
+
+NS_OBJECT_ENSURE_REGISTERED(SourceRouteTag);
+NS_OBJECT_ENSURE_REGISTERED(SourceRouting);
+
+SourceRouteTag::SourceRouteTag(uint32_t path)
+    : m_path(path)
+{
+}
+
+TypeId
+SourceRouteTag::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::SourceRouteTag")
+                            .SetParent<Tag>()
+                            .SetGroupName("Internet")
+                            .AddConstructor<SourceRouteTag>();
+    return tid;
+}
+
+TypeId
+SourceRouteTag::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+SourceRouteTag::GetSerializedSize() const
+{
+    return 4;
+}
+
+void
+SourceRouteTag::Serialize(TagBuffer buf) const
+{
+    buf.WriteU32(m_path);
+}
+
+void
+SourceRouteTag::Deserialize(TagBuffer buf)
+{
+    m_path = buf.ReadU32();
+}
+
+void
+SourceRouteTag::Print(std::ostream& os) const
+{
+    os << "path=" << m_path;
+}
+
+uint32_t
+SourceRouteTag::GetPath() const
+{
+    return m_path;
+}
+
+TypeId
+SourceRouting::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::SourceRouting")
+                            .SetParent<Ipv4RoutingProtocol>()
+                            .SetGroupName("Internet")
+                            .AddConstructor<SourceRouting>();
+    return tid;
+}
+
+void
+SourceRouting::SetTable(uint32_t self, std::shared_ptr<SourceRouteTable> table)
+{
+    m_self = self;
+    m_table = table;
+}
+
+void
+SourceRouting::AddNeighbor(uint32_t neighbor, uint32_t iface, Ipv4Address gateway)
+{
+    m_neighbors.emplace(neighbor, Hop{iface, gateway});
+}
+
+void
+SourceRouting::AddOrigin(Ipv4Address dest, uint32_t path)
+{
+    m_origins.emplace(dest.Get(), path);
+}
+
+Ptr<Ipv4Route>
+SourceRouting::NextHop(uint32_t path, Ipv4Address dest) const
+{
+    if (!m_table || path >= m_table->paths.size())
+        return nullptr;
+    return NextHop(m_table->paths[path], dest);
+}
+
+Ptr<Ipv4Route>
+SourceRouting::NextHop(const std::vector<uint32_t>& hops, Ipv4Address dest) const
+{
+    // Paths are loop-free, so this node appears at most once
+    for (size_t i = 0; i + 1 < hops.size(); ++i)
+    {
+        if (hops[i] != m_self)
+            continue;
+        auto it = m_neighbors.find(hops[i + 1]);
+        if (it == m_neighbors.end())
+            return nullptr;
+        Ptr<Ipv4Route> route = Create<Ipv4Route>();
+        route->SetDestination(dest);
+        route->SetGateway(it->second.gateway);
+        route->SetSource(m_ipv4->GetAddress(it->second.iface, 0).GetLocal());
+        route->SetOutputDevice(m_ipv4->GetNetDevice(it->second.iface));
+        return route;
+    }
+    return nullptr;
+}
+
+std::vector<uint32_t>
+SourceRouting::ShortestPath(Ipv4Address dest) const
+{
+    if (!m_table)
+        return {};
+    auto node = m_table->nodeOf.find(dest.Get());
+    if (node == m_table->nodeOf.end() || node->second == m_self)
+        return {};
+
+    // Breadth-first from this node; neighbours are in index order, so the
+    // path is the same in every run
+    uint32_t target = node->second;
+    const std::vector<std::vector<uint32_t>>& adj = m_table->neighbors;
+    std::vector<uint32_t> parent(adj.size(), UINT32_MAX);
+    std::vector<uint32_t> queue{m_self};
+    parent[m_self] = m_self;
+    for (size_t q = 0; q < queue.size() && parent[target] == UINT32_MAX; ++q)
+    {
+        for (uint32_t next : adj[queue[q]])
+        {
+            if (parent[next] == UINT32_MAX)
+            {
+                parent[next] = queue[q];
+                queue.push_back(next);
+            }
+        }
+    }
+    if (parent[target] == UINT32_MAX)
+        return {};
+
+    std::vector<uint32_t> path{target};
+    while (path.back() != m_self)
+        path.push_back(parent[path.back()]);
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+uint32_t
+SourceRouting::AddShortestPath(Ipv4Address dest)
+{
+    std::vector<uint32_t> path = ShortestPath(dest);
+    if (path.empty())
+        return UINT32_MAX;
+    m_table->paths.push_back(std::move(path));
+    uint32_t index = m_table->paths.size() - 1;
+    m_origins[dest.Get()] = index;
+    return index;
+}
+
+Ptr<Ipv4Route>
+SourceRouting::RouteOutput(Ptr<Packet> p,
+                           const Ipv4Header& header,
+                           Ptr<NetDevice> oif,
+                           Socket::SocketErrno& sockerr)
+{
+    sockerr = Socket::ERROR_NOROUTETOHOST;
+    auto origin = m_origins.find(header.GetDestination().Get());
+    if (!p)
+    {
+        // Route lookup without a packet: answer as a packet would be sent,
+        // but leave the path table alone
+        Ptr<Ipv4Route> route = origin != m_origins.end()
+                                   ? NextHop(origin->second, header.GetDestination())
+                                   : NextHop(ShortestPath(header.GetDestination()),
+                                             header.GetDestination());
+        if (!route || (oif && route->GetOutputDevice() != oif))
+            return nullptr;
+        sockerr = Socket::ERROR_NOTERROR;
+        return route;
+    }
+    SourceRouteTag tag;
+    if (p->PeekPacketTag(tag))
+    {
+        // Tagged by the flow's application
+        Ptr<Ipv4Route> route = NextHop(tag.GetPath(), header.GetDestination());
+        if (!route || (oif && route->GetOutputDevice() != oif))
+            return nullptr;
+        sockerr = Socket::ERROR_NOTERROR;
+        return route;
+    }
+    uint32_t path = origin != m_origins.end() ? origin->second
+                                              : AddShortestPath(header.GetDestination());
+    Ptr<Ipv4Route> route = NextHop(path, header.GetDestination());
+    if (!route || (oif && route->GetOutputDevice() != oif))
+        return nullptr;
+
+    p->AddPacketTag(SourceRouteTag(path));
+    sockerr = Socket::ERROR_NOTERROR;
+    return route;
+}
+
+bool
+SourceRouting::RouteInput(Ptr<const Packet> p,
+                          const Ipv4Header& header,
+                          Ptr<const NetDevice> idev,
+                          const UnicastForwardCallback& ucb,
+                          const MulticastForwardCallback& mcb,
+                          const LocalDeliverCallback& lcb,
+                          const ErrorCallback& ecb)
+{
+    // Local delivery is handled by the list routing before any protocol
+    SourceRouteTag tag;
+    if (header.GetDestination().IsMulticast() || !p->PeekPacketTag(tag))
+        return false;
+    Ptr<Ipv4Route> route = NextHop(tag.GetPath(), header.GetDestination());
+    if (!route)
+        return false;
+    ucb(route, p, header);
+    return true;
+}
+
+void
+SourceRouting::NotifyInterfaceUp(uint32_t iface)
+{
+}
+
+void
+SourceRouting::NotifyInterfaceDown(uint32_t iface)
+{
+}
+
+void
+SourceRouting::NotifyAddAddress(uint32_t iface, Ipv4InterfaceAddress address)
+{
+}
+
+void
+SourceRouting::NotifyRemoveAddress(uint32_t iface, Ipv4InterfaceAddress address)
+{
+}
+
+void
+SourceRouting::SetIpv4(Ptr<Ipv4> ipv4)
+{
+    m_ipv4 = ipv4;
+}
+
+void
+SourceRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+{
+    *stream->GetStream() << "SourceRouting: node " << m_self << ", " << m_neighbors.size()
+                         << " neighbours, " << m_origins.size() << " originated paths\n";
+}
+
+void
+SourceRouting::DoDispose()
+{
+    m_ipv4 = nullptr;
+    m_table.reset();
+    m_neighbors.clear();
+    m_origins.clear();
+    Ipv4RoutingProtocol::DoDispose();
+}
+
+void
+TagFlowPath(Ptr<Application> app, uint32_t path)
+{
+    app->TraceConnectWithoutContext(
+        "Tx",
+        Callback<void, Ptr<const Packet>>([path](Ptr<const Packet> p) {
+            // Tx hands over the packet the socket is about to send
+            ConstCast<Packet>(p)->AddPacketTag(SourceRouteTag(path));
+        }));
+}
+
+SourceRoutingHelper*
+SourceRoutingHelper::Copy() const
+{
+    return new SourceRoutingHelper(*this);
+}
+
+Ptr<Ipv4RoutingProtocol>
+SourceRoutingHelper::Create(Ptr<Node> node) const
+{
+    return CreateObject<SourceRouting>();
+}
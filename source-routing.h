@@ -0,0 +1,119 @@
+#ifndef SOURCE_ROUTING_H
+#define SOURCE_ROUTING_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// State shared by every node in --routing=source: the paths (node indices,
+// src first, dst last) and the link graph, from which a sender adds a
+// shortest-hop path to a destination routing.json gives it none for.
+struct SourceRouteTable
+{
+    std::vector<std::vector<uint32_t>> paths;
+    std::vector<std::vector<uint32_t>> neighbors; // node -> adjacent nodes
+    std::unordered_map<uint32_t, uint32_t> nodeOf; // interface address -> node
+};
+
+// Packet tag naming the path a packet follows. ns-3 caps packet tags at 21
+// bytes, so the tag holds an index into the shared SourceRouteTable paths
+// rather than the hop list itself.
+class SourceRouteTag : public ns3::Tag
+{
+  public:
+    SourceRouteTag(uint32_t path = 0);
+
+    static ns3::TypeId GetTypeId();
+    ns3::TypeId GetInstanceTypeId() const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(ns3::TagBuffer buf) const override;
+    void Deserialize(ns3::TagBuffer buf) override;
+    void Print(std::ostream& os) const override;
+
+    uint32_t GetPath() const;
+
+  private:
+    uint32_t m_path;
+};
+
+// Forwards by the path in the packet's SourceRouteTag: each node finds itself
+// on the path and sends to the following node, so intermediate nodes only
+// know their neighbours. A packet its application already tagged (TagFlowPath)
+// keeps that path; otherwise the source tags it with its destination's path,
+// adding a shortest-hop one on first use if it has none. Packets it cannot
+// route and untagged ones fall through to the next protocol in the list.
+class SourceRouting : public ns3::Ipv4RoutingProtocol
+{
+  public:
+    static ns3::TypeId GetTypeId();
+
+    void SetTable(uint32_t self, std::shared_ptr<SourceRouteTable> table);
+    // Link to node `neighbor` leaves through `iface` towards `gateway`.
+    void AddNeighbor(uint32_t neighbor, uint32_t iface, ns3::Ipv4Address gateway);
+    // Untagged packets this node originates for `dest` follow path `path`;
+    // the first path given for a destination is kept.
+    void AddOrigin(ns3::Ipv4Address dest, uint32_t path);
+
+    ns3::Ptr<ns3::Ipv4Route> RouteOutput(ns3::Ptr<ns3::Packet> p,
+                                         const ns3::Ipv4Header& header,
+                                         ns3::Ptr<ns3::NetDevice> oif,
+                                         ns3::Socket::SocketErrno& sockerr) override;
+    bool RouteInput(ns3::Ptr<const ns3::Packet> p,
+                    const ns3::Ipv4Header& header,
+                    ns3::Ptr<const ns3::NetDevice> idev,
+                    const UnicastForwardCallback& ucb,
+                    const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb,
+                    const ErrorCallback& ecb) override;
+    void NotifyInterfaceUp(uint32_t iface) override;
+    void NotifyInterfaceDown(uint32_t iface) override;
+    void NotifyAddAddress(uint32_t iface, ns3::Ipv4InterfaceAddress address) override;
+    void NotifyRemoveAddress(uint32_t iface, ns3::Ipv4InterfaceAddress address) override;
+    void SetIpv4(ns3::Ptr<ns3::Ipv4> ipv4) override;
+    void PrintRoutingTable(ns3::Ptr<ns3::OutputStreamWrapper> stream,
+                           ns3::Time::Unit unit = ns3::Time::S) const override;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    struct Hop
+    {
+        uint32_t iface;
+        ns3::Ipv4Address gateway;
+    };
+
+    // Route to the node after this one on `path`, or nullptr.
+    ns3::Ptr<ns3::Ipv4Route> NextHop(uint32_t path, ns3::Ipv4Address dest) const;
+    ns3::Ptr<ns3::Ipv4Route> NextHop(const std::vector<uint32_t>& hops,
+                                     ns3::Ipv4Address dest) const;
+    // Shortest-hop path from this node to `dest`'s node, or empty.
+    std::vector<uint32_t> ShortestPath(ns3::Ipv4Address dest) const;
+    // Index of a new shortest-hop path to `dest`'s node, or UINT32_MAX.
+    uint32_t AddShortestPath(ns3::Ipv4Address dest);
+
+    ns3::Ptr<ns3::Ipv4> m_ipv4;
+    uint32_t m_self = 0;
+    std::shared_ptr<SourceRouteTable> m_table;
+    std::unordered_map<uint32_t, Hop> m_neighbors;  // node index -> link
+    std::unordered_map<uint32_t, uint32_t> m_origins; // destination address -> path
+};
+
+// Tag every packet `app` sends with path `path`, so that one flow of a pair
+// with several routes follows its own. Uses the app's Tx trace source, which
+// fires before the packet reaches the socket.
+void TagFlowPath(ns3::Ptr<ns3::Application> app, uint32_t path);
+
+class SourceRoutingHelper : public ns3::Ipv4RoutingHelper
+{
+  public:
+    SourceRoutingHelper* Copy() const override;
+    ns3::Ptr<ns3::Ipv4RoutingProtocol> Create(ns3::Ptr<ns3::Node> node) const override;
+};
+
+#endif // SOURCE_ROUTING_H
@@ -0,0 +1,425 @@
+#include "step-env.h"
+
+#include "sim-probes.h"
+
+#include "ns3/point-to-point-module.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("StepEnv");
+
+bool
+EnvSend(int fd, const void* buf, size_t len)
+{
+    const char* p = static_cast<const char*>(buf);
+    while (len > 0)
+    {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool
+EnvRecv(int fd, void* buf, size_t len)
+{
+    char* p = static_cast<char*>(buf);
+    while (len > 0)
+    {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+int
+EnvAccept(const std::string& path, int& listenFd)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        std::cerr << "Socket path too long: " << path << "\n";
+        return -1;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listenFd, 1) != 0)
+    {
+        std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+        return -1;
+    }
+    int fd;
+    do
+    {
+        fd = accept(listenFd, nullptr, nullptr);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0)
+        std::cerr << "Accept failed on " << path << ": " << std::strerror(errno) << "\n";
+    return fd;
+}
+
+static size_t
+RegionSize(const EnvHeader& h)
+{
+    return sizeof(EnvHeader) + sizeof(EnvState) * h.nEnvs +
+           sizeof(double) * h.nEnvs * (2 * h.nLinks + h.nFlows) +
+           sizeof(uint32_t) * (2 * h.nLinks + h.nEnvs * (2 * h.nFlows + 3 * h.maxActions));
+}
+
+EnvRegion::~EnvRegion()
+{
+    Unmap();
+}
+
+bool
+EnvRegion::Create(const std::string& file, const EnvHeader& dims)
+{
+    int fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0 || ftruncate(fd, RegionSize(dims)) != 0 || !Map(fd, RegionSize(dims)))
+    {
+        std::cerr << "Cannot create " << file << ": " << std::strerror(errno) << "\n";
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    close(fd);
+    *header = dims;
+    header->magic = kEnvMagic;
+    header->version = kEnvVersion;
+    Layout();
+    return true;
+}
+
+bool
+EnvRegion::Attach(const std::string& file)
+{
+    int fd = open(file.c_str(), O_RDWR);
+    EnvHeader dims{};
+    bool ok = fd >= 0 && pread(fd, &dims, sizeof(dims), 0) == sizeof(dims) &&
+              dims.magic == kEnvMagic && dims.version == kEnvVersion &&
+              Map(fd, RegionSize(dims));
+    if (ok)
+        Layout();
+    else
+        std::cerr << "Cannot attach " << file << "\n";
+    if (fd >= 0)
+        close(fd);
+    return ok;
+}
+
+bool
+EnvRegion::Map(int fd, size_t bytes)
+{
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+        return false;
+    header = static_cast<EnvHeader*>(base);
+    size = bytes;
+    return true;
+}
+
+void
+EnvRegion::Layout()
+{
+    const EnvHeader& h = *header;
+    state = reinterpret_cast<EnvState*>(header + 1);
+    linkUtil = reinterpret_cast<double*>(state + h.nEnvs);
+    queuePackets = linkUtil + h.nEnvs * h.nLinks;
+    flowMbps = queuePackets + h.nEnvs * h.nLinks;
+    linkEnds = reinterpret_cast<uint32_t*>(flowMbps + h.nEnvs * h.nFlows);
+    flowEnds = linkEnds + 2 * h.nLinks;
+    actions = flowEnds + h.nEnvs * 2 * h.nFlows;
+}
+
+void
+EnvRegion::Unmap()
+{
+    if (header)
+        munmap(header, size);
+    header = nullptr;
+    state = nullptr;
+    linkUtil = queuePackets = flowMbps = nullptr;
+    linkEnds = flowEnds = actions = nullptr;
+    size = 0;
+}
+
+StepEnvironment::StepEnvironment(const NodeContainer& nodes,
+                                 const std::vector<NetDeviceContainer>& linkDevs,
+                                 const std::vector<Ipv4Address>& nodeAddr,
+                                 const std::vector<std::pair<uint32_t, uint32_t>>& flowPairs,
+                                 const std::vector<Ptr<PacketSink>>& sinks,
+                                 double step,
+                                 uint32_t maxActions)
+    : m_nodes(nodes),
+      m_linkDevs(linkDevs),
+      m_nodeAddr(nodeAddr),
+      m_flowPairs(flowPairs),
+      m_sinks(sinks),
+      m_step(step),
+      m_maxActions(maxActions),
+      m_lastLinkBytes(2 * linkDevs.size(), 0),
+      m_lastRxBytes(flowPairs.size(), 0)
+{
+    std::map<Ptr<Node>, uint32_t> index;
+    for (uint32_t n = 0; n < nodes.GetN(); ++n)
+        index[nodes.Get(n)] = n;
+    for (uint32_t k = 0; k < linkDevs.size(); ++k)
+    {
+        uint32_t a = index[linkDevs[k].Get(0)->GetNode()];
+        uint32_t b = index[linkDevs[k].Get(1)->GetNode()];
+        m_linkOf.emplace(std::make_pair(a, b), 2 * k);
+        m_linkOf.emplace(std::make_pair(b, a), 2 * k + 1);
+        for (uint32_t side = 0; side < 2; ++side)
+        {
+            Ptr<NetDevice> dev = linkDevs[k].Get(side);
+            Ptr<TrafficControlLayer> tc = dev->GetNode()->GetObject<TrafficControlLayer>();
+            m_qdiscs.push_back(tc ? tc->GetRootQueueDiscOnDevice(dev) : nullptr);
+        }
+    }
+}
+
+StepEnvironment::~StepEnvironment()
+{
+    Close();
+}
+
+bool
+StepEnvironment::Open(const std::string& path)
+{
+    m_path = path;
+    EnvHeader dims{};
+    dims.nEnvs = 1;
+    dims.nNodes = m_nodes.GetN();
+    dims.nLinks = 2 * m_linkDevs.size();
+    dims.nFlows = m_flowPairs.size();
+    dims.maxActions = m_maxActions;
+    std::string shmFile = path + ".shm";
+    if (!m_region.Create(shmFile, dims))
+        return false;
+    UseSlot(0);
+
+    NS_LOG_UNCOND("[ENV] Waiting for an agent on " << path << " (" << m_region.size
+                                                   << " shared bytes in " << shmFile << ")");
+    m_fd = EnvAccept(path, m_listenFd);
+    if (m_fd < 0)
+        return false;
+    NS_LOG_UNCOND("[ENV] Agent connected, " << m_step << "s steps");
+    return true;
+}
+
+bool
+StepEnvironment::Join(const std::string& path, uint32_t slot, int fd)
+{
+    m_fd = fd;
+    if (!m_region.Attach(path + ".shm"))
+        return false;
+    const EnvHeader& h = *m_region.header;
+    if (slot >= h.nEnvs || h.nLinks != 2 * m_linkDevs.size() || h.nFlows != m_flowPairs.size() ||
+        h.maxActions != m_maxActions)
+    {
+        std::cerr << "Environment slot " << slot << " does not match " << path << ".shm\n";
+        return false;
+    }
+    UseSlot(slot);
+    return true;
+}
+
+void
+StepEnvironment::UseSlot(uint32_t slot)
+{
+    const EnvHeader& h = *m_region.header;
+    m_state = m_region.state + slot;
+    m_linkUtil = m_region.linkUtil + slot * h.nLinks;
+    m_queuePackets = m_region.queuePackets + slot * h.nLinks;
+    m_flowMbps = m_region.flowMbps + slot * h.nFlows;
+    m_actions = m_region.actions + slot * 3 * h.maxActions;
+    uint32_t* flowEnds = m_region.flowEnds + slot * 2 * h.nFlows;
+
+    // Every slot shares the built topology, so the link table is the same
+    for (auto& kv : m_linkOf)
+    {
+        m_region.linkEnds[2 * kv.second] = kv.first.first;
+        m_region.linkEnds[2 * kv.second + 1] = kv.first.second;
+    }
+    for (uint32_t f = 0; f < m_flowPairs.size(); ++f)
+    {
+        flowEnds[2 * f] = m_flowPairs[f].first;
+        flowEnds[2 * f + 1] = m_flowPairs[f].second;
+    }
+    m_state->step = 0;
+    m_state->done = 0;
+}
+
+void
+StepEnvironment::Start()
+{
+    Simulator::Schedule(Seconds(m_step), &StepEnvironment::Step, this);
+}
+
+void
+StepEnvironment::Observe()
+{
+    double now = Simulator::Now().GetSeconds();
+    double dt = now - m_lastTime;
+    for (uint32_t d = 0; d < m_lastLinkBytes.size(); ++d)
+    {
+        Ptr<NetDevice> dev = m_linkDevs[d / 2].Get(d % 2);
+        Ptr<Queue<Packet>> queue = DynamicCast<PointToPointNetDevice>(dev)->GetQueue();
+        // Everything the device queue accepted is sent within a packet time
+        uint32_t bytes = queue->GetTotalReceivedBytes() - queue->GetTotalDroppedBytes();
+        uint32_t sent = bytes - m_lastLinkBytes[d];
+        DataRateValue rate;
+        dev->GetAttribute("DataRate", rate);
+        double capacity = rate.Get().GetBitRate() * dt;
+        m_linkUtil[d] = capacity > 0.0 ? sent * 8.0 / capacity : 0.0;
+        m_lastLinkBytes[d] = bytes;
+        m_queuePackets[d] = queue->GetNPackets() + (m_qdiscs[d] ? m_qdiscs[d]->GetNPackets() : 0);
+    }
+    for (uint32_t f = 0; f < m_lastRxBytes.size(); ++f)
+    {
+        uint64_t rx = m_sinks[f] ? m_sinks[f]->GetTotalRx() : 0;
+        m_flowMbps[f] = dt > 0.0 ? (rx - m_lastRxBytes[f]) * 8.0 / dt / 1e6 : 0.0;
+        m_lastRxBytes[f] = rx;
+    }
+    m_lastTime = now;
+    m_state->simTime = now;
+}
+
+void
+StepEnvironment::Step()
+{
+    Observe();
+    m_state->step++;
+    m_state->nActions = 0;
+    uint64_t step = m_state->step;
+    uint32_t command = 0;
+    if (!EnvSend(m_fd, &step, sizeof(step)) || !EnvRecv(m_fd, &command, sizeof(command)))
+    {
+        NS_LOG_UNCOND("[ENV] Agent hung up at t=" << m_state->simTime << "s, stopping");
+        Simulator::Stop();
+        return;
+    }
+    ApplyActions();
+    if (command == 0)
+    {
+        NS_LOG_UNCOND("[ENV] Agent stopped the run at t=" << m_state->simTime << "s");
+        Simulator::Stop();
+        return;
+    }
+    Simulator::Schedule(Seconds(m_step), &StepEnvironment::Step, this);
+}
+
+void
+StepEnvironment::ApplyActions()
+{
+    uint32_t n = std::min(m_state->nActions, m_maxActions);
+    uint32_t applied = 0;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        if (SetNextHop(m_actions[3 * i], m_actions[3 * i + 1], m_actions[3 * i + 2]))
+            applied++;
+    }
+    m_state->applied = applied;
+    m_state->rejected = m_state->nActions - applied;
+}
+
+bool
+StepEnvironment::SetNextHop(uint32_t node, uint32_t dst, uint32_t nextHop)
+{
+    auto link = m_linkOf.find(std::make_pair(node, nextHop));
+    if (link == m_linkOf.end() || dst >= m_nodeAddr.size() || dst == node)
+        return false;
+    uint32_t k = link->second / 2;
+    uint32_t side = link->second % 2;
+    Ptr<NetDevice> local = m_linkDevs[k].Get(side);
+    Ptr<NetDevice> remote = m_linkDevs[k].Get(1 - side);
+    Ptr<Ipv4> ipv4 = m_nodes.Get(node)->GetObject<Ipv4>();
+    Ptr<Ipv4> peer = remote->GetNode()->GetObject<Ipv4>();
+    Ipv4StaticRoutingHelper helper;
+    Ptr<Ipv4StaticRouting> sr = helper.GetStaticRouting(ipv4);
+    if (!sr)
+        return false;
+
+    // Replace rather than stack host routes, so tables stay bounded over steps
+    for (uint32_t i = sr->GetNRoutes(); i-- > 0;)
+    {
+        Ipv4RoutingTableEntry e = sr->GetRoute(i);
+        if (e.IsHost() && e.GetDest() == m_nodeAddr[dst])
+        {
+            sr->RemoveRoute(i);
+            SIM_PROBE5(route_del,
+                       node,
+                       e.GetDest().Get(),
+                       e.GetGateway().Get(),
+                       e.GetInterface(),
+                       "agent");
+            if (m_routeLog)
+                m_routeLog->Removed(node, e.GetDest(), e.GetGateway(), e.GetInterface(), "agent");
+        }
+    }
+    Ipv4Address gateway = peer->GetAddress(peer->GetInterfaceForDevice(remote), 0).GetLocal();
+    uint32_t iface = ipv4->GetInterfaceForDevice(local);
+    sr->AddHostRouteTo(m_nodeAddr[dst], gateway, iface, 0);
+    SIM_PROBE5(route_add, node, m_nodeAddr[dst].Get(), gateway.Get(), iface, "agent");
+    if (m_routeLog)
+        m_routeLog->Added(node, m_nodeAddr[dst], gateway, iface, "agent");
+    return true;
+}
+
+void
+StepEnvironment::Finish()
+{
+    if (m_fd < 0)
+        return;
+    Observe();
+    m_state->step++;
+    m_state->done = m_listenFd >= 0 ? 2 : 1; // on its own, a run is the only episode
+    uint64_t step = m_state->step;
+    EnvSend(m_fd, &step, sizeof(step));
+    NS_LOG_UNCOND("[ENV] Run finished after " << step << " steps");
+    Close();
+}
+
+void
+StepEnvironment::SetRouteLog(RouteLog* log)
+{
+    m_routeLog = log;
+}
+
+void
+StepEnvironment::Close()
+{
+    if (m_fd >= 0)
+        close(m_fd);
+    if (m_listenFd >= 0)
+    {
+        close(m_listenFd);
+        unlink(m_path.c_str());
+    }
+    m_region.Unmap();
+    m_fd = -1;
+    m_listenFd = -1;
+}
@@ -0,0 +1,170 @@
+#ifndef STEP_ENV_H
+#define STEP_ENV_H
+
+#include "route-log.h"
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Shared observation/action region (native byte order) for nEnvs
+// environments: a single run has nEnvs = 1, an EnvPool one per worker.
+// EnvHeader, EnvState[nEnvs], then the arrays, doubles first so that every
+// array stays aligned:
+//   double linkUtil[nEnvs][nLinks]       share of capacity sent in the last step
+//   double queuePackets[nEnvs][nLinks]   device queue + queue disc backlog
+//   double flowMbps[nEnvs][nFlows]       throughput received in the last step
+//   uint32 linkEnds[nLinks][2]           directed link i runs [i][0] -> [i][1]
+//   uint32 flowEnds[nEnvs][nFlows][2]
+//   uint32 actions[nEnvs][maxActions][3] (node, destination, next hop), agent-written
+// Directed link 2k is topology.json link k from src to dst, 2k+1 the reverse.
+// python/ns3_env.py mirrors this layout.
+struct EnvHeader
+{
+    uint32_t magic; // kEnvMagic
+    uint32_t version;
+    uint32_t nEnvs;
+    uint32_t nNodes;
+    uint32_t nLinks; // directed
+    uint32_t nFlows;
+    uint32_t maxActions;
+    uint32_t reserved;
+};
+
+struct EnvState
+{
+    uint64_t step;
+    double simTime;
+    uint32_t done;     // 1: episode's final observation, 2: the slot's last (or idle)
+    uint32_t nActions; // set by the agent before it replies
+    uint32_t applied;  // actions of the previous reply that were installed
+    uint32_t rejected; // ... and those that named no such node or link
+    uint32_t episode;  // pool-wide episode number (RngRun offset)
+    uint32_t reserved;
+};
+
+static_assert(sizeof(EnvHeader) == 32 && sizeof(EnvState) == 40,
+              "The shared layout is mirrored by python/ns3_env.py");
+
+const uint32_t kEnvMagic = 0x4e533345; // "NS3E"
+const uint32_t kEnvVersion = 2;
+
+// Whole-message send/recv on a blocking stream socket.
+bool EnvSend(int fd, const void* buf, size_t len);
+bool EnvRecv(int fd, void* buf, size_t len);
+// Listen on a Unix-domain socket at `path` (kept open in `listenFd`) and
+// accept one agent; returns its descriptor or -1.
+int EnvAccept(const std::string& path, int& listenFd);
+
+// A mapping of the shared region.
+struct EnvRegion
+{
+    EnvHeader* header = nullptr;
+    EnvState* state = nullptr;
+    double* linkUtil = nullptr;
+    double* queuePackets = nullptr;
+    double* flowMbps = nullptr;
+    uint32_t* linkEnds = nullptr;
+    uint32_t* flowEnds = nullptr;
+    uint32_t* actions = nullptr;
+    size_t size = 0;
+
+    EnvRegion() = default;
+    EnvRegion(const EnvRegion&) = delete;
+    EnvRegion& operator=(const EnvRegion&) = delete;
+    ~EnvRegion();
+
+    // Create (or truncate) `file` for the dimensions in `dims` and map it.
+    bool Create(const std::string& file, const EnvHeader& dims);
+    // Map a region created by another process.
+    bool Attach(const std::string& file);
+    void Unmap();
+
+  private:
+    bool Map(int fd, size_t size);
+    // Point the arrays into the mapping according to the header.
+    void Layout();
+};
+
+// Step-wise control of a packet run by an external agent (--env=PATH).
+// Every `step` seconds of simulated time the run writes an observation into
+// its slot of the shared region, sends its step number over a stream socket
+// and blocks until the reply. The reply is one uint32: 1 continues (after
+// installing the actions written into the slot), 0 stops the run.
+// Observations and actions never go through the socket, so a step costs two
+// small messages. On its own (Open) the run creates PATH.shm and talks to the
+// agent directly on a Unix-domain socket at PATH; inside an EnvPool (Join) it
+// talks to the pool process, which batches the agent's steps.
+//
+// An action (node, destination, next hop) replaces the node's host routes to
+// the destination's traffic address with one via the link to the next hop.
+class StepEnvironment
+{
+  public:
+    // `linkDevs[k]` are the devices of topology.json link k (src side first)
+    // and `sinks[f]` flow f's receiver (null if the flow was not installed).
+    StepEnvironment(const ns3::NodeContainer& nodes,
+                    const std::vector<ns3::NetDeviceContainer>& linkDevs,
+                    const std::vector<ns3::Ipv4Address>& nodeAddr,
+                    const std::vector<std::pair<uint32_t, uint32_t>>& flowPairs,
+                    const std::vector<ns3::Ptr<ns3::PacketSink>>& sinks,
+                    double step,
+                    uint32_t maxActions);
+    ~StepEnvironment();
+
+    // Create PATH.shm and the socket, then wait for the agent to connect.
+    bool Open(const std::string& path);
+    // Use slot `slot` of an EnvPool's PATH.shm, reporting steps on `fd`.
+    bool Join(const std::string& path, uint32_t slot, int fd);
+    // Schedule the first step.
+    void Start();
+    // Publish the final observation (done = 2 on its own, 1 in a pool) and hang up.
+    void Finish();
+    // Report route changes made by actions to `log` (null = none).
+    void SetRouteLog(RouteLog* log);
+
+  private:
+    // Point at slot `slot` and publish the topology.
+    void UseSlot(uint32_t slot);
+    void Step();
+    void Observe();
+    void ApplyActions();
+    bool SetNextHop(uint32_t node, uint32_t dst, uint32_t nextHop);
+    void Close();
+
+    ns3::NodeContainer m_nodes;
+    std::vector<ns3::NetDeviceContainer> m_linkDevs;
+    std::vector<ns3::Ipv4Address> m_nodeAddr;
+    std::vector<std::pair<uint32_t, uint32_t>> m_flowPairs;
+    std::vector<ns3::Ptr<ns3::PacketSink>> m_sinks;
+    double m_step;
+    uint32_t m_maxActions;
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> m_linkOf; // (u, v) -> directed link
+    std::vector<ns3::Ptr<ns3::QueueDisc>> m_qdiscs;              // per directed link, or null
+
+    std::vector<uint32_t> m_lastLinkBytes; // queue byte counters are 32-bit and wrap
+    std::vector<uint64_t> m_lastRxBytes;
+    double m_lastTime = 0.0;
+
+    std::string m_path;
+    int m_listenFd = -1;
+    int m_fd = -1;
+    EnvRegion m_region;
+    EnvState* m_state = nullptr;
+    double* m_linkUtil = nullptr;
+    double* m_queuePackets = nullptr;
+    double* m_flowMbps = nullptr;
+    uint32_t* m_actions = nullptr;
+    RouteLog* m_routeLog = nullptr;
+};
+
+#endif // STEP_ENV_H
@@ -0,0 +1,561 @@
+#include "topology-gen.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <unordered_set>
+#include <utility>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TopologyGen");
+
+namespace
+{
+
+// key=value pairs of a spec, remembering which ones a generator read.
+class GenParams
+{
+  public:
+    bool Parse(const std::string& list)
+    {
+        std::istringstream iss(list);
+        for (std::string item; std::getline(iss, item, ',');)
+        {
+            std::string::size_type eq = item.find('=');
+            if (eq == std::string::npos || eq == 0)
+            {
+                std::cerr << "Invalid --gen parameter: " << item << "\n";
+                return false;
+            }
+            m_values[item.substr(0, eq)] = item.substr(eq + 1);
+        }
+        return true;
+    }
+
+    // Non-negative integer that fits in T; prints an error and returns false
+    // for anything else, e.g. -5, 4.5 or abc.
+    template <class T>
+    bool Int(const std::string& key, T def, T& value)
+    {
+        m_used.insert(key);
+        auto it = m_values.find(key);
+        if (it == m_values.end())
+        {
+            value = def;
+            return true;
+        }
+        const std::string& s = it->second;
+        char* end = nullptr;
+        errno = 0;
+        unsigned long long v = std::strtoull(s.c_str(), &end, 10);
+        if (s.empty() || !std::isdigit(static_cast<unsigned char>(s[0])) || *end != '\0' ||
+            errno == ERANGE || v > std::numeric_limits<T>::max())
+        {
+            std::cerr << "Invalid --gen " << key << ": " << s << " (not a non-negative integer)\n";
+            return false;
+        }
+        value = T(v);
+        return true;
+    }
+
+    // Finite number; prints an error and returns false for anything else.
+    bool Real(const std::string& key, double def, double& value)
+    {
+        m_used.insert(key);
+        auto it = m_values.find(key);
+        if (it == m_values.end())
+        {
+            value = def;
+            return true;
+        }
+        const std::string& s = it->second;
+        char* end = nullptr;
+        value = std::strtod(s.c_str(), &end);
+        if (s.empty() || *end != '\0' || !std::isfinite(value))
+        {
+            std::cerr << "Invalid --gen " << key << ": " << s << " (not a number)\n";
+            return false;
+        }
+        return true;
+    }
+
+    std::string Str(const std::string& key, const std::string& def)
+    {
+        m_used.insert(key);
+        auto it = m_values.find(key);
+        return it == m_values.end() ? def : it->second;
+    }
+
+    // Link rate and delay, checked here because DataRate and Time abort on
+    // malformed strings once the links are built.
+    bool Rate(const std::string& key, const std::string& def, std::string& value)
+    {
+        value = Str(key, def);
+        if (IsDataRate(value))
+            return true;
+        std::cerr << "Invalid --gen " << key << ": " << value << " (not a data rate)\n";
+        return false;
+    }
+
+    bool Delay(const std::string& key, const std::string& def, std::string& value)
+    {
+        value = Str(key, def);
+        if (IsDelay(value))
+            return true;
+        std::cerr << "Invalid --gen " << key << ": " << value << " (not a non-negative time)\n";
+        return false;
+    }
+
+    bool AllUsed(const std::string& kind) const
+    {
+        for (auto& kv : m_values)
+        {
+            if (!m_used.count(kv.first))
+            {
+                std::cerr << "Unknown --gen parameter for " << kind << ": " << kv.first << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+  private:
+    std::map<std::string, std::string> m_values;
+    std::set<std::string> m_used;
+};
+
+// Appends links with the spec's bandwidth/delay profile. The core profile is
+// set only by the generators that have switch-to-switch links.
+struct LinkBuilder
+{
+    std::vector<LinkSpec>& links;
+    std::string bw;
+    std::string delay;
+    std::string coreBw;
+    std::string coreDelay;
+
+    void Add(uint32_t a, uint32_t b, bool core = false)
+    {
+        links.push_back(LinkSpec{a, b, core ? coreBw : bw, core ? coreDelay : delay, "", ""});
+    }
+
+    void Add(uint32_t a, uint32_t b, const std::string& linkDelay)
+    {
+        links.push_back(LinkSpec{a, b, bw, linkDelay, "", ""});
+    }
+};
+
+// Refuse sizes the addressing plan cannot number before building anything;
+// a connected topology has at least nNodes - 1 links. Callers bound the node
+// count first so that their link products cannot overflow.
+bool
+CheckSize(const char* kind, uint64_t nNodes, uint64_t nLinks)
+{
+    if (nNodes > kMaxLinks + 1)
+        std::cerr << kind << " is too large: " << nNodes << " nodes (at most " << kMaxLinks + 1
+                  << ")\n";
+    else if (nLinks > kMaxLinks)
+        std::cerr << kind << " is too large: " << nLinks << " links (at most " << kMaxLinks
+                  << ")\n";
+    else
+        return true;
+    return false;
+}
+
+uint64_t
+EdgeKey(uint32_t a, uint32_t b)
+{
+    return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+
+// Core switches, then per pod k/2 aggregation and k/2 edge switches, then hosts.
+bool
+FatTree(GenParams& p, LinkBuilder& out, uint32_t& nNodes)
+{
+    uint32_t k;
+    uint32_t withHosts;
+    if (!p.Int<uint32_t>("k", 4, k) || !p.Int<uint32_t>("hosts", 1, withHosts) ||
+        !p.Rate("coreBw", "40Mbps", out.coreBw) || !p.Delay("coreDelay", "1ms", out.coreDelay))
+        return false;
+    bool hosts = withHosts != 0;
+    if (k < 2 || k % 2 != 0)
+    {
+        std::cerr << "fattree needs an even k >= 2\n";
+        return false;
+    }
+    uint64_t switches = uint64_t(k / 2) * (k / 2) + uint64_t(k) * k;
+    if (!CheckSize("fattree", switches, 0))
+        return false;
+    uint64_t perLayer = uint64_t(k) * k * k / 4; // links per layer, hosts per tree
+    if (!CheckSize("fattree", switches + (hosts ? perLayer : 0), perLayer * (hosts ? 3 : 2)))
+        return false;
+    uint32_t half = k / 2;
+    uint32_t nCore = half * half;
+    uint32_t firstAgg = nCore;
+    uint32_t firstEdge = firstAgg + k * half;
+    uint32_t firstHost = firstEdge + k * half;
+    nNodes = firstHost + (hosts ? k * half * half : 0);
+    for (uint32_t pod = 0; pod < k; ++pod)
+    {
+        for (uint32_t a = 0; a < half; ++a)
+        {
+            for (uint32_t j = 0; j < half; ++j)
+                out.Add(a * half + j, firstAgg + pod * half + a, true);
+        }
+        for (uint32_t e = 0; e < half; ++e)
+        {
+            uint32_t edge = firstEdge + pod * half + e;
+            for (uint32_t a = 0; a < half; ++a)
+                out.Add(firstAgg + pod * half + a, edge, true);
+            for (uint32_t h = 0; hosts && h < half; ++h)
+                out.Add(edge, firstHost + (pod * half + e) * half + h);
+        }
+    }
+    return true;
+}
+
+// Spines, then leaves, then hosts.
+bool
+LeafSpine(GenParams& p, LinkBuilder& out, uint32_t& nNodes)
+{
+    uint32_t leaves;
+    uint32_t spines;
+    uint32_t hosts;
+    if (!p.Int<uint32_t>("leaves", 4, leaves) || !p.Int<uint32_t>("spines", 2, spines) ||
+        !p.Int<uint32_t>("hosts", 0, hosts) || !p.Rate("coreBw", "40Mbps", out.coreBw) ||
+        !p.Delay("coreDelay", "1ms", out.coreDelay))
+        return false;
+    if (leaves < 1 || spines < 1)
+    {
+        std::cerr << "leafspine needs at least one leaf and one spine\n";
+        return false;
+    }
+    if (!CheckSize("leafspine", spines + uint64_t(leaves) * (1 + uint64_t(hosts)), 0) ||
+        !CheckSize("leafspine", 0, uint64_t(leaves) * (uint64_t(spines) + hosts)))
+        return false;
+    nNodes = spines + leaves * (1 + hosts);
+    for (uint32_t l = 0; l < leaves; ++l)
+    {
+        uint32_t leaf = spines + l;
+        for (uint32_t s = 0; s < spines; ++s)
+            out.Add(s, leaf, true);
+        for (uint32_t h = 0; h < hosts; ++h)
+            out.Add(leaf, spines + leaves + l * hosts + h);
+    }
+    return true;
+}
+
+// Random regular graph built as in Jellyfish (Singla et al., NSDI 2012):
+// join random non-adjacent switches with free ports; when that gets stuck,
+// split a random link to give its ends to a switch with two free ports.
+bool
+Jellyfish(GenParams& p, LinkBuilder& out, uint32_t& nNodes, std::mt19937_64& rng)
+{
+    uint32_t n;
+    uint32_t degree;
+    if (!p.Int<uint32_t>("n", 16, n) || !p.Int<uint32_t>("degree", 4, degree))
+        return false;
+    if (n < 2 || degree < 1 || degree >= n)
+    {
+        std::cerr << "jellyfish needs n >= 2 and 1 <= degree < n\n";
+        return false;
+    }
+    if (!CheckSize("jellyfish", n, uint64_t(n) * degree / 2))
+        return false;
+    nNodes = n;
+    std::vector<uint32_t> ports(n, degree);
+    std::vector<uint32_t> open(n); // switches with free ports
+    std::vector<uint32_t> pos(n);  // index in `open`
+    for (uint32_t v = 0; v < n; ++v)
+        open[v] = pos[v] = v;
+    std::unordered_set<uint64_t> adjacent;
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    adjacent.reserve(size_t(n) * degree);
+    edges.reserve(size_t(n) * degree / 2);
+
+    auto use = [&](uint32_t v) {
+        if (--ports[v] > 0)
+            return;
+        open[pos[v]] = open.back();
+        pos[open.back()] = pos[v];
+        open.pop_back();
+    };
+    auto link = [&](uint32_t a, uint32_t b) {
+        adjacent.insert(EdgeKey(a, b));
+        edges.emplace_back(a, b);
+        use(a);
+        use(b);
+    };
+    auto linkAnyOpenPair = [&]() {
+        for (size_t i = 0; i < open.size(); ++i)
+        {
+            for (size_t j = i + 1; j < open.size(); ++j)
+            {
+                if (!adjacent.count(EdgeKey(open[i], open[j])))
+                {
+                    link(open[i], open[j]);
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    uint32_t misses = 0;
+    while (open.size() >= 2 || (open.size() == 1 && ports[open[0]] >= 2))
+    {
+        uint32_t a = open[rng() % open.size()];
+        uint32_t b = open[rng() % open.size()];
+        if (a != b && !adjacent.count(EdgeKey(a, b)))
+        {
+            link(a, b);
+            misses = 0;
+            continue;
+        }
+        if (++misses < 64)
+            continue;
+        misses = 0;
+        if (linkAnyOpenPair())
+            continue;
+
+        auto spare = std::find_if(open.begin(), open.end(), [&](uint32_t v) {
+            return ports[v] >= 2;
+        });
+        if (spare == open.end())
+            break; // a few single free ports are left over
+        uint32_t v = *spare;
+        bool split = false;
+        for (uint32_t tries = 0; tries < 1024 && !split && !edges.empty(); ++tries)
+        {
+            size_t e = rng() % edges.size();
+            uint32_t x = edges[e].first;
+            uint32_t y = edges[e].second;
+            if (x == v || y == v || adjacent.count(EdgeKey(v, x)) || adjacent.count(EdgeKey(v, y)))
+                continue;
+            // x and y keep their port counts: each trades y (or x) for v
+            adjacent.erase(EdgeKey(x, y));
+            edges[e] = edges.back();
+            edges.pop_back();
+            adjacent.insert(EdgeKey(v, x));
+            adjacent.insert(EdgeKey(v, y));
+            edges.emplace_back(v, x);
+            edges.emplace_back(v, y);
+            use(v);
+            use(v);
+            split = true;
+        }
+        if (!split)
+            break;
+    }
+    for (auto& e : edges)
+        out.Add(e.first, e.second);
+    return true;
+}
+
+// Waxman (1988): nodes uniform in the unit square, u-v linked with
+// probability alpha * exp(-d / (beta * sqrt(2))). O(n^2) pairs.
+bool
+Waxman(GenParams& p, LinkBuilder& out, uint32_t& nNodes, std::mt19937_64& rng)
+{
+    uint32_t n;
+    double alpha;
+    double beta;
+    if (!p.Int<uint32_t>("n", 32, n) || !p.Real("alpha", 0.4, alpha) ||
+        !p.Real("beta", 0.2, beta))
+        return false;
+    if (n < 2 || !(alpha > 0.0) || !(beta > 0.0))
+    {
+        std::cerr << "waxman needs n >= 2 and positive alpha and beta\n";
+        return false;
+    }
+    if (!CheckSize("waxman", n, n - 1))
+        return false;
+    nNodes = n;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<double> x(n);
+    std::vector<double> y(n);
+    for (uint32_t v = 0; v < n; ++v)
+    {
+        x[v] = uniform(rng);
+        y[v] = uniform(rng);
+    }
+    const double diagonal = std::sqrt(2.0);
+    double maxDelayUs = Time(out.delay).GetSeconds() * 1e6;
+    auto distance = [&](uint32_t a, uint32_t b) { return std::hypot(x[a] - x[b], y[a] - y[b]); };
+    auto add = [&](uint32_t a, uint32_t b) {
+        int64_t us = std::max<int64_t>(1, std::llround(maxDelayUs * distance(a, b) / diagonal));
+        out.Add(a, b, std::to_string(us) + "us");
+    };
+
+    std::vector<uint32_t> parent(n);
+    for (uint32_t v = 0; v < n; ++v)
+        parent[v] = v;
+    auto find = [&](uint32_t v) {
+        while (parent[v] != v)
+            v = parent[v] = parent[parent[v]];
+        return v;
+    };
+    for (uint32_t a = 0; a < n; ++a)
+    {
+        for (uint32_t b = a + 1; b < n; ++b)
+        {
+            if (uniform(rng) < alpha * std::exp(-distance(a, b) / (beta * diagonal)))
+            {
+                add(a, b);
+                parent[find(a)] = find(b);
+            }
+        }
+    }
+
+    // Join every other component to node 0's through its nearest node there
+    for (uint32_t v = 1; v < n; ++v)
+    {
+        if (find(v) == find(0))
+            continue;
+        uint32_t nearest = 0;
+        for (uint32_t u = 1; u < n; ++u)
+        {
+            if (find(u) == find(0) && distance(u, v) < distance(nearest, v))
+                nearest = u;
+        }
+        add(nearest, v);
+        parent[find(v)] = find(0);
+    }
+    return true;
+}
+
+// Barabasi-Albert preferential attachment from a clique of m + 1 nodes.
+bool
+BarabasiAlbert(GenParams& p, LinkBuilder& out, uint32_t& nNodes, std::mt19937_64& rng)
+{
+    uint32_t n;
+    uint32_t m;
+    if (!p.Int<uint32_t>("n", 32, n) || !p.Int<uint32_t>("m", 2, m))
+        return false;
+    if (m < 1 || n <= m)
+    {
+        std::cerr << "ba needs 1 <= m < n\n";
+        return false;
+    }
+    // m(m+1)/2 clique links, then m per later node
+    if (!CheckSize("ba", n, uint64_t(m) * (m + 1) / 2 + uint64_t(n - m - 1) * m))
+        return false;
+    nNodes = n;
+    std::vector<uint32_t> endpoints; // each node once per incident link
+    endpoints.reserve(2 * size_t(n) * m);
+    for (uint32_t a = 0; a <= m; ++a)
+    {
+        for (uint32_t b = a + 1; b <= m; ++b)
+        {
+            out.Add(a, b);
+            endpoints.push_back(a);
+            endpoints.push_back(b);
+        }
+    }
+    std::vector<uint32_t> targets;
+    for (uint32_t v = m + 1; v < n; ++v)
+    {
+        targets.clear();
+        while (targets.size() < m)
+        {
+            uint32_t t = endpoints[rng() % endpoints.size()];
+            if (std::find(targets.begin(), targets.end(), t) == targets.end())
+                targets.push_back(t);
+        }
+        for (uint32_t t : targets)
+        {
+            out.Add(t, v);
+            endpoints.push_back(t);
+            endpoints.push_back(v);
+        }
+    }
+    return true;
+}
+
+// rows x cols grid with wrap-around links (none where a ring would double up).
+bool
+Torus(GenParams& p, LinkBuilder& out, uint32_t& nNodes)
+{
+    uint32_t rows;
+    uint32_t cols;
+    if (!p.Int<uint32_t>("rows", 4, rows) || !p.Int<uint32_t>("cols", 4, cols))
+        return false;
+    uint64_t size = uint64_t(rows) * cols;
+    if (size < 2)
+    {
+        std::cerr << "torus needs at least two nodes\n";
+        return false;
+    }
+    if (!CheckSize("torus", size, 2 * size))
+        return false;
+    nNodes = rows * cols;
+    for (uint32_t r = 0; r < rows; ++r)
+    {
+        for (uint32_t c = 0; c < cols; ++c)
+        {
+            uint32_t v = r * cols + c;
+            if (c + 1 < cols || cols > 2)
+                out.Add(v, r * cols + (c + 1) % cols);
+            if (r + 1 < rows || rows > 2)
+                out.Add(v, ((r + 1) % rows) * cols + c);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool
+GenerateTopology(const std::string& spec, uint32_t& nNodes, std::vector<LinkSpec>& links)
+{
+    std::string::size_type colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    GenParams p;
+    if (colon != std::string::npos && !p.Parse(spec.substr(colon + 1)))
+        return false;
+
+    links.clear();
+    std::string bw;
+    std::string delay;
+    uint64_t seed;
+    if (!p.Rate("bw", "10Mbps", bw) || !p.Delay("delay", "1ms", delay) ||
+        !p.Int<uint64_t>("seed", 1, seed))
+        return false;
+    LinkBuilder out{links, bw, delay, "", ""};
+    std::mt19937_64 rng(seed);
+    bool ok;
+    if (kind == "fattree")
+        ok = FatTree(p, out, nNodes);
+    else if (kind == "leafspine")
+        ok = LeafSpine(p, out, nNodes);
+    else if (kind == "jellyfish")
+        ok = Jellyfish(p, out, nNodes, rng);
+    else if (kind == "waxman")
+        ok = Waxman(p, out, nNodes, rng);
+    else if (kind == "ba")
+        ok = BarabasiAlbert(p, out, nNodes, rng);
+    else if (kind == "torus")
+        ok = Torus(p, out, nNodes);
+    else
+    {
+        std::cerr << "Unknown topology generator: " << kind << "\n";
+        return false;
+    }
+    if (!ok || !p.AllUsed(kind))
+        return false;
+
+    NS_LOG_UNCOND("Generated " << kind << " topology: " << nNodes << " nodes, " << links.size()
+                               << " links");
+    return true;
+}
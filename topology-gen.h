@@ -0,0 +1,29 @@
+#ifndef TOPOLOGY_GEN_H
+#define TOPOLOGY_GEN_H
+
+#include "topology-spec.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Build a synthetic topology straight into `links` from a --gen spec,
+// KIND[:key=value,...]. Kinds and their size keys (defaults in brackets):
+//   fattree    k [4], even; hosts [1] adds k/2 hosts under every edge switch
+//   leafspine  leaves [4], spines [2], hosts [0] per leaf
+//   jellyfish  n [16] switches, degree [4] (random regular graph)
+//   waxman     n [32], alpha [0.4], beta [0.2] in the unit square
+//   ba         n [32], m [2] links per new node (Barabasi-Albert)
+//   torus      rows [4], cols [4]
+// Every link gets bw [10Mbps] and delay [1ms]; switch-to-switch links of
+// fattree and leafspine get coreBw [40Mbps] and coreDelay [1ms] instead.
+// Waxman delays scale with distance, reaching `delay` at the square's
+// diagonal, and the graph is joined into one component. Random kinds draw
+// from `seed` [1], independent of RngRun. Sizes and seed must be
+// non-negative integers. Prints an error and returns false for an unknown
+// kind or key (coreBw/coreDelay included, outside fattree and leafspine), a
+// malformed value or rate or delay, unusable sizes, or more links than the
+// addressing plan can number (kMaxLinks).
+bool GenerateTopology(const std::string& spec, uint32_t& nNodes, std::vector<LinkSpec>& links);
+
+#endif // TOPOLOGY_GEN_H
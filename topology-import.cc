@@ -0,0 +1,667 @@
+#include "topology-import.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TopologyImport");
+
+namespace
+{
+
+std::string
+Lower(std::string s)
+{
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+    return s;
+}
+
+std::string
+Trim(const std::string& s)
+{
+    size_t b = s.find_first_not_of(" \t\r\n");
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return b == std::string::npos ? "" : s.substr(b, e - b + 1);
+}
+
+bool
+EndsWith(const std::string& s, const std::string& suffix)
+{
+    return s.size() >= suffix.size() &&
+           s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool
+IsNumber(const std::string& s, double& value)
+{
+    if (s.empty())
+        return false;
+    char* end = nullptr;
+    value = std::strtod(s.c_str(), &end);
+    return *end == '\0';
+}
+
+uint64_t
+EdgeKey(uint32_t a, uint32_t b)
+{
+    return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+
+// Dense node indices in order of first appearance.
+class NodeIds
+{
+  public:
+    uint32_t Get(const std::string& id)
+    {
+        auto it = m_ids.emplace(id, uint32_t(m_ids.size())).first;
+        return it->second;
+    }
+
+    uint32_t Size() const
+    {
+        return m_ids.size();
+    }
+
+  private:
+    std::unordered_map<std::string, uint32_t> m_ids;
+};
+
+// Minimal pull parser: enough XML for GraphML, without building a tree.
+// Comments, processing instructions and the DOCTYPE are skipped; element
+// names lose their namespace prefix; <a/> yields START then END.
+class XmlReader
+{
+  public:
+    enum Event
+    {
+        START,
+        END,
+        TEXT,
+        DONE,
+        ERROR
+    };
+
+    explicit XmlReader(std::istream& in)
+        : m_buf(in.rdbuf())
+    {
+    }
+
+    Event Next()
+    {
+        if (m_pendingEnd)
+        {
+            m_pendingEnd = false;
+            m_attrs.clear();
+            return END;
+        }
+        for (;;)
+        {
+            int c = m_buf->sbumpc();
+            if (c == EOF)
+                return DONE;
+            if (c != '<')
+            {
+                m_text.assign(1, char(c));
+                while (m_buf->sgetc() != EOF && m_buf->sgetc() != '<')
+                    m_text += char(m_buf->sbumpc());
+                m_text = Decode(m_text);
+                return TEXT;
+            }
+            c = m_buf->sgetc();
+            if (c == '?')
+            {
+                if (!SkipPast("?>"))
+                    return ERROR;
+            }
+            else if (c == '!')
+            {
+                m_buf->sbumpc();
+                std::string head;
+                for (int i = 0; i < 7 && m_buf->sgetc() != EOF; ++i)
+                {
+                    head += char(m_buf->sbumpc());
+                    if (head == "--")
+                        break;
+                }
+                if (head == "--")
+                {
+                    if (!SkipPast("-->"))
+                        return ERROR;
+                }
+                else if (head == "[CDATA[")
+                {
+                    m_text.clear();
+                    return ReadUntil("]]>", m_text) ? TEXT : ERROR;
+                }
+                else if (!SkipDeclaration())
+                {
+                    return ERROR;
+                }
+            }
+            else if (c == '/')
+            {
+                m_buf->sbumpc();
+                std::string tag;
+                if (!ReadUntil(">", tag))
+                    return ERROR;
+                m_name = LocalName(Trim(tag));
+                m_attrs.clear();
+                return END;
+            }
+            else
+            {
+                return ReadStartTag() ? START : ERROR;
+            }
+        }
+    }
+
+    // Element name of the last START or END
+    const std::string& Name() const
+    {
+        return m_name;
+    }
+
+    // Character data of the last TEXT, entities decoded
+    const std::string& Text() const
+    {
+        return m_text;
+    }
+
+    std::string Attr(const std::string& key) const
+    {
+        for (const auto& kv : m_attrs)
+        {
+            if (kv.first == key)
+                return kv.second;
+        }
+        return "";
+    }
+
+    bool HasAttr(const std::string& key) const
+    {
+        for (const auto& kv : m_attrs)
+        {
+            if (kv.first == key)
+                return true;
+        }
+        return false;
+    }
+
+  private:
+    static std::string LocalName(const std::string& name)
+    {
+        size_t colon = name.find(':');
+        return colon == std::string::npos ? name : name.substr(colon + 1);
+    }
+
+    static std::string Decode(const std::string& s)
+    {
+        if (s.find('&') == std::string::npos)
+            return s;
+        static const std::pair<const char*, char> kEntities[] = {
+            {"amp", '&'}, {"lt", '<'}, {"gt", '>'}, {"quot", '"'}, {"apos", '\''}};
+        std::string out;
+        for (size_t i = 0; i < s.size(); ++i)
+        {
+            size_t semi = s[i] == '&' ? s.find(';', i) : std::string::npos;
+            if (semi == std::string::npos)
+            {
+                out += s[i];
+                continue;
+            }
+            std::string name = s.substr(i + 1, semi - i - 1);
+            bool known = false;
+            for (const auto& e : kEntities)
+            {
+                if (name == e.first)
+                {
+                    out += e.second;
+                    known = true;
+                }
+            }
+            if (!known && name.size() > 1 && name[0] == '#')
+            {
+                long code = name[1] == 'x' ? std::strtol(name.c_str() + 2, nullptr, 16)
+                                           : std::strtol(name.c_str() + 1, nullptr, 10);
+                // Non-ASCII characters never matter to the importer
+                out += code > 0 && code < 128 ? char(code) : '?';
+                known = true;
+            }
+            if (known)
+                i = semi;
+            else
+                out += s[i];
+        }
+        return out;
+    }
+
+    bool SkipPast(const std::string& terminator)
+    {
+        std::string ignored;
+        return ReadUntil(terminator, ignored);
+    }
+
+    // Append everything up to `terminator` to `out` and consume the terminator
+    bool ReadUntil(const std::string& terminator, std::string& out)
+    {
+        for (int c; (c = m_buf->sbumpc()) != EOF;)
+        {
+            out += char(c);
+            if (EndsWith(out, terminator))
+            {
+                out.resize(out.size() - terminator.size());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // <!DOCTYPE ...>, including an internal subset in brackets
+    bool SkipDeclaration()
+    {
+        int depth = 0;
+        for (int c; (c = m_buf->sbumpc()) != EOF;)
+        {
+            if (c == '[')
+                ++depth;
+            else if (c == ']')
+                --depth;
+            else if (c == '>' && depth <= 0)
+                return true;
+        }
+        return false;
+    }
+
+    void SkipSpace()
+    {
+        while (m_buf->sgetc() != EOF && std::isspace(m_buf->sgetc()))
+            m_buf->sbumpc();
+    }
+
+    bool ReadStartTag()
+    {
+        m_name.clear();
+        m_attrs.clear();
+        while (m_buf->sgetc() != EOF && !std::isspace(m_buf->sgetc()) && m_buf->sgetc() != '>' &&
+               m_buf->sgetc() != '/')
+            m_name += char(m_buf->sbumpc());
+        m_name = LocalName(m_name);
+        for (;;)
+        {
+            SkipSpace();
+            int c = m_buf->sbumpc();
+            if (c == '>')
+                return !m_name.empty();
+            if (c == '/')
+            {
+                m_pendingEnd = true;
+                return m_buf->sbumpc() == '>' && !m_name.empty();
+            }
+            if (c == EOF)
+                return false;
+            std::string key(1, char(c));
+            while (m_buf->sgetc() != EOF && !std::isspace(m_buf->sgetc()) && m_buf->sgetc() != '=')
+                key += char(m_buf->sbumpc());
+            SkipSpace();
+            if (m_buf->sbumpc() != '=')
+                return false;
+            SkipSpace();
+            int quote = m_buf->sbumpc();
+            if (quote != '"' && quote != '\'')
+                return false;
+            std::string value;
+            if (!ReadUntil(std::string(1, char(quote)), value))
+                return false;
+            m_attrs.emplace_back(key, Decode(value));
+        }
+    }
+
+    std::streambuf* m_buf;
+    std::string m_name;
+    std::string m_text;
+    std::vector<std::pair<std::string, std::string>> m_attrs;
+    bool m_pendingEnd = false;
+};
+
+using DataMap = std::map<std::string, std::string>;
+
+std::string
+Lookup(const DataMap& data, const char* key)
+{
+    auto it = data.find(key);
+    return it == data.end() ? "" : it->second;
+}
+
+std::string
+FormatBps(double bps)
+{
+    return std::to_string(uint64_t(std::llround(bps))) + "bps";
+}
+
+// Capacity of a GraphML edge, or "" if it has none
+std::string
+EdgeBandwidth(const DataMap& data)
+{
+    double value;
+    if (IsNumber(Lookup(data, "linkspeedraw"), value) && value > 0)
+        return FormatBps(value);
+    if (IsNumber(Lookup(data, "linkspeed"), value) && value > 0)
+    {
+        std::string units = Lower(Lookup(data, "linkspeedunits"));
+        double scale = units == "k" ? 1e3 : units == "g" ? 1e9 : units == "t" ? 1e12 : 1e6;
+        return FormatBps(value * scale);
+    }
+    for (const char* key : {"capacity", "bandwidth", "bw"})
+    {
+        std::string bw = Lookup(data, key);
+        if (!bw.empty())
+            return IsNumber(bw, value) ? bw + "Mbps" : bw;
+    }
+    return "";
+}
+
+// Latency of a GraphML edge, or "" if it has none
+std::string
+EdgeDelay(const DataMap& data)
+{
+    double value;
+    for (const char* key : {"delay", "latency"})
+    {
+        std::string delay = Lookup(data, key);
+        if (!delay.empty())
+            return IsNumber(delay, value) ? delay + "ms" : delay;
+    }
+    return "";
+}
+
+// Great-circle distance in km
+double
+Haversine(double lat1, double lon1, double lat2, double lon2)
+{
+    const double rad = M_PI / 180.0;
+    double dLat = (lat2 - lat1) * rad;
+    double dLon = (lon2 - lon1) * rad;
+    double sLat = std::sin(dLat / 2);
+    double sLon = std::sin(dLon / 2);
+    double a = sLat * sLat + std::cos(lat1 * rad) * std::cos(lat2 * rad) * sLon * sLon;
+    return 2 * 6371.0 * std::asin(std::sqrt(std::min(1.0, a)));
+}
+
+bool
+ReadGraphml(std::istream& in,
+            const std::string& file,
+            const ImportOptions& opts,
+            uint32_t& nNodes,
+            std::vector<LinkSpec>& links)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    XmlReader xml(in);
+    std::map<std::string, std::string> keys; // <key> id -> lowercase attr.name
+    NodeIds ids;
+    std::vector<double> lat;
+    std::vector<double> lon;
+    std::unordered_set<uint64_t> directedPairs;
+    bool directed = false;
+    enum
+    {
+        NONE,
+        NODE,
+        EDGE
+    } element = NONE;
+    uint32_t node = 0;
+    uint32_t src = 0;
+    uint32_t dst = 0;
+    bool edgeDirected = false;
+    DataMap data;
+    std::string dataKey;
+    std::string text;
+    bool inData = false;
+
+    links.clear();
+    for (;;)
+    {
+        XmlReader::Event ev = xml.Next();
+        if (ev == XmlReader::ERROR)
+        {
+            std::cerr << "Malformed XML in " << file << "\n";
+            return false;
+        }
+        if (ev == XmlReader::DONE)
+            break;
+        const std::string& name = xml.Name();
+        if (ev == XmlReader::TEXT)
+        {
+            if (inData)
+                text += xml.Text();
+        }
+        else if (ev == XmlReader::START)
+        {
+            if (name == "key")
+            {
+                keys[xml.Attr("id")] = Lower(xml.Attr("attr.name"));
+            }
+            else if (name == "graph")
+            {
+                directed = xml.Attr("edgedefault") == "directed";
+            }
+            else if (name == "node")
+            {
+                node = ids.Get(xml.Attr("id"));
+                element = NODE;
+                data.clear();
+            }
+            else if (name == "edge")
+            {
+                src = ids.Get(xml.Attr("source"));
+                dst = ids.Get(xml.Attr("target"));
+                edgeDirected = xml.HasAttr("directed") ? xml.Attr("directed") == "true" : directed;
+                element = EDGE;
+                data.clear();
+            }
+            else if (name == "data" && element != NONE)
+            {
+                auto it = keys.find(xml.Attr("key"));
+                dataKey = it != keys.end() && !it->second.empty() ? it->second
+                                                                   : Lower(xml.Attr("key"));
+                text.clear();
+                inData = true;
+            }
+        }
+        else if (name == "data" && inData)
+        {
+            data[dataKey] = Trim(text);
+            inData = false;
+        }
+        else if (name == "node" && element == NODE)
+        {
+            lat.resize(ids.Size(), nan);
+            lon.resize(ids.Size(), nan);
+            double value;
+            if (IsNumber(Lookup(data, "latitude"), value))
+                lat[node] = value;
+            if (IsNumber(Lookup(data, "longitude"), value))
+                lon[node] = value;
+            element = NONE;
+        }
+        else if (name == "edge" && element == EDGE)
+        {
+            element = NONE;
+            if (src == dst)
+                continue;
+            if (edgeDirected)
+            {
+                // Keep a->b once, whether or not b->a is also listed
+                if (directedPairs.count((uint64_t(dst) << 32) | src))
+                    continue;
+                directedPairs.insert((uint64_t(src) << 32) | dst);
+            }
+            // An empty delay is filled in from coordinates once all nodes are known
+            links.push_back(LinkSpec{src, dst, EdgeBandwidth(data), EdgeDelay(data), "", ""});
+        }
+    }
+
+    nNodes = ids.Size();
+    lat.resize(nNodes, nan);
+    lon.resize(nNodes, nan);
+    for (LinkSpec& l : links)
+    {
+        if (l.bw.empty())
+            l.bw = opts.bw;
+        if (!l.delay.empty())
+            continue;
+        if (std::isnan(lat[l.src]) || std::isnan(lon[l.src]) || std::isnan(lat[l.dst]) ||
+            std::isnan(lon[l.dst]))
+        {
+            l.delay = opts.delay;
+            continue;
+        }
+        double km = Haversine(lat[l.src], lon[l.src], lat[l.dst], lon[l.dst]);
+        l.delay = std::to_string(std::max<int64_t>(1, std::llround(km * 5.0))) + "us";
+    }
+    return true;
+}
+
+// .cch router maps: "uid @loc [+] [bb] (n) &ext -> <nuid> ... {-euid} ... =name rN".
+// Lines of external routers start with '-'.
+bool
+ReadRocketfuelMap(std::istream& in,
+                  const ImportOptions& opts,
+                  uint32_t& nNodes,
+                  std::vector<LinkSpec>& links)
+{
+    NodeIds ids;
+    std::unordered_set<uint64_t> seen;
+    links.clear();
+    for (std::string line; std::getline(in, line);)
+    {
+        std::istringstream iss(line);
+        std::string uid;
+        if (!(iss >> uid) || uid[0] == '-' || uid[0] == '#')
+            continue;
+        uint32_t a = ids.Get(uid);
+        for (std::string tok; iss >> tok;)
+        {
+            if (tok.size() < 3 || tok.front() != '<' || tok.back() != '>')
+                continue;
+            uint32_t b = ids.Get(tok.substr(1, tok.size() - 2));
+            if (a != b && seen.insert(EdgeKey(a, b)).second)
+                links.push_back(LinkSpec{a, b, opts.bw, opts.delay, "", ""});
+        }
+    }
+    nNodes = ids.Size();
+    return true;
+}
+
+// weights.intra / latencies.intra: "name1 name2 value" per line
+bool
+ReadRocketfuelPairs(std::istream& in,
+                    const std::string& file,
+                    const ImportOptions& opts,
+                    uint32_t& nNodes,
+                    std::vector<LinkSpec>& links)
+{
+    bool latencies = Lower(file).find("latenc") != std::string::npos;
+    NodeIds ids;
+    std::unordered_set<uint64_t> seen;
+    links.clear();
+    uint32_t lineNo = 0;
+    for (std::string line; std::getline(in, line);)
+    {
+        ++lineNo;
+        std::istringstream iss(line);
+        std::string n1;
+        std::string n2;
+        double value;
+        if (!(iss >> n1) || n1[0] == '#')
+            continue;
+        if (!(iss >> n2 >> value))
+        {
+            std::cerr << file << ":" << lineNo << ": expected \"name name value\"\n";
+            return false;
+        }
+        uint32_t a = ids.Get(n1);
+        uint32_t b = ids.Get(n2);
+        if (a == b || !seen.insert(EdgeKey(a, b)).second)
+            continue;
+        std::string delay = opts.delay;
+        if (latencies)
+        {
+            std::ostringstream oss;
+            oss << value << "ms";
+            delay = oss.str();
+        }
+        links.push_back(LinkSpec{a, b, opts.bw, delay, "", ""});
+    }
+    nNodes = ids.Size();
+    return true;
+}
+
+} // namespace
+
+std::string
+TopologyFormat(const std::string& file)
+{
+    std::string name = Lower(file.substr(file.find_last_of('/') + 1));
+    if (EndsWith(name, ".graphml") || EndsWith(name, ".xml"))
+        return "graphml";
+    if (EndsWith(name, ".cch") || name.find("weights") != std::string::npos ||
+        name.find("latenc") != std::string::npos)
+        return "rocketfuel";
+    return "json";
+}
+
+bool
+ImportTopology(const std::string& file,
+               const ImportOptions& opts,
+               uint32_t& nNodes,
+               std::vector<LinkSpec>& links)
+{
+    std::string format = opts.format.empty() ? TopologyFormat(file) : opts.format;
+    if (format != "graphml" && format != "rocketfuel")
+    {
+        std::cerr << "Unknown topology format for import: " << format << "\n";
+        return false;
+    }
+    std::ifstream in(file);
+    if (!in)
+    {
+        std::cerr << "Cannot open " << file << "\n";
+        return false;
+    }
+    bool ok;
+    if (format == "graphml")
+        ok = ReadGraphml(in, file, opts, nNodes, links);
+    else if (EndsWith(Lower(file), ".cch"))
+        ok = ReadRocketfuelMap(in, opts, nNodes, links);
+    else
+        ok = ReadRocketfuelPairs(in, file, opts, nNodes, links);
+    if (!ok)
+        return false;
+    if (links.empty())
+    {
+        std::cerr << "No links found in " << file << "\n";
+        return false;
+    }
+    if (links.size() > kMaxLinks)
+    {
+        std::cerr << file << " has " << links.size() << " links, more than the " << kMaxLinks
+                  << " that can be addressed\n";
+        return false;
+    }
+    NS_LOG_UNCOND("Imported " << format << " topology: " << nNodes << " nodes, " << links.size()
+                              << " links");
+    return true;
+}
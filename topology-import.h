@@ -0,0 +1,43 @@
+#ifndef TOPOLOGY_IMPORT_H
+#define TOPOLOGY_IMPORT_H
+
+#include "topology-spec.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Streaming readers for published topology formats. Files are read once,
+// front to back; only node ids, coordinates and the links are kept.
+//
+// graphml     GraphML, e.g. Internet Topology Zoo. Capacity comes from the
+//             edge's LinkSpeedRaw (bps), LinkSpeed + LinkSpeedUnits, or a
+//             capacity/bandwidth attribute (a number is in Mbps). Delay comes
+//             from a delay/latency attribute (a number is in ms), or else from
+//             the great-circle distance between the ends' Latitude/Longitude
+//             at 5 us/km, the speed of light in fibre. Self-loops are dropped,
+//             and so are reverse duplicates in directed graphs.
+// rocketfuel  Rocketfuel router maps (.cch: "uid @loc ... -> <nuid> ...") or
+//             weights/latencies files ("name name value", value in ms for a
+//             latencies file). External routers are skipped and each link is
+//             kept once.
+struct ImportOptions
+{
+    std::string format;        // graphml, rocketfuel; empty = TopologyFormat(file)
+    std::string bw = "10Mbps"; // links without a capacity
+    std::string delay = "1ms"; // links without a latency or coordinates
+};
+
+// Format implied by a file name: graphml for *.graphml / *.xml, rocketfuel
+// for *.cch and weights/latencies files, else json.
+std::string TopologyFormat(const std::string& file);
+
+// Read `file` into nodes and links. Prints an error and returns false if the
+// file cannot be read, is not in the expected format or has more than
+// kMaxLinks links.
+bool ImportTopology(const std::string& file,
+                    const ImportOptions& opts,
+                    uint32_t& nNodes,
+                    std::vector<LinkSpec>& links);
+
+#endif // TOPOLOGY_IMPORT_H
@@ -0,0 +1,206 @@
+#include "topology-spec.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <set>
+#include <sstream>
+
+using json = nlohmann::json;
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TopologySpec");
+
+bool
+IsQueueType(const std::string& type)
+{
+    return type == "DropTail" || type == "RED" || type == "CoDel" || type == "FqCoDel";
+}
+
+bool
+IsDataRate(const std::string& rate)
+{
+    // DataRate's stream extraction flags a bad rate; its constructor aborts
+    std::istringstream in(rate);
+    DataRate parsed;
+    return !rate.empty() && (in >> parsed) && in.peek() == std::char_traits<char>::eof();
+}
+
+bool
+IsDelay(const std::string& delay)
+{
+    // Split as Time's string constructor does, which aborts on a bad unit
+    static const std::set<std::string> units{"", "s", "ms", "us", "ns", "ps", "fs", "min", "h",
+                                             "d", "y"};
+    std::string::size_type n = delay.find_first_not_of("+-0123456789.eE");
+    std::string number = delay.substr(0, n);
+    char* end = nullptr;
+    double value = std::strtod(number.c_str(), &end);
+    return !number.empty() && *end == '\0' && value >= 0.0 &&
+           units.count(n == std::string::npos ? "" : delay.substr(n));
+}
+
+bool
+LoadTopology(const std::string& file,
+             uint32_t& nNodes,
+             std::vector<LinkSpec>& links,
+             std::vector<LinkEvent>& events)
+{
+    json topo;
+    {
+        std::ifstream in(file);
+        if (!in.is_open())
+        {
+            std::cerr << "Failed to open topology file: " << file << "\n";
+            return false;
+        }
+        in >> topo;
+    }
+
+    nNodes = topo.value("nodes", 0u);
+    for (auto& l : topo["links"])
+    {
+        LinkSpec s;
+        s.src = l["src"].get<uint32_t>();
+        s.dst = l["dst"].get<uint32_t>();
+        s.bw = l.value("bandwidth", "10Mbps");
+        s.delay = l.value("delay", "10ms");
+        s.queueType = l.value("queue", "");
+        s.queueSize = l.value("queue_size", "");
+        if (!s.queueType.empty() && !IsQueueType(s.queueType))
+        {
+            std::cerr << "Unknown queue type " << s.queueType << " on link " << s.src << "-"
+                      << s.dst << "\n";
+            return false;
+        }
+        links.push_back(s);
+    }
+    if (links.size() > kMaxLinks)
+    {
+        std::cerr << file << " has " << links.size() << " links, more than the " << kMaxLinks
+                  << " that can be addressed\n";
+        return false;
+    }
+
+    if (!topo.contains("events"))
+        return true;
+    for (auto& e : topo["events"])
+    {
+        bool byEnds = e.contains("src") && e.contains("dst");
+        if (!e.contains("time") || !e.contains("type") || (!e.contains("link") && !byEnds))
+        {
+            std::cerr << "Event needs a time, a type and a link or src/dst: " << e.dump() << "\n";
+            return false;
+        }
+        LinkEvent ev;
+        ev.time = e["time"].get<double>();
+        ev.type = e["type"].get<std::string>();
+        ev.bw = e.value("bandwidth", "");
+        ev.link = links.size();
+        if (e.contains("link"))
+        {
+            ev.link = e["link"].get<uint32_t>();
+        }
+        else
+        {
+            // Match either orientation of src/dst
+            uint32_t a = e["src"].get<uint32_t>();
+            uint32_t b = e["dst"].get<uint32_t>();
+            for (uint32_t k = 0; k < links.size(); ++k)
+            {
+                if ((links[k].src == a && links[k].dst == b) ||
+                    (links[k].src == b && links[k].dst == a))
+                {
+                    ev.link = k;
+                    break;
+                }
+            }
+        }
+        if (ev.link >= links.size())
+        {
+            std::cerr << "Event at " << ev.time << "s refers to an unknown link\n";
+            return false;
+        }
+        if (ev.type != "link_down" && ev.type != "link_up" && ev.type != "capacity")
+        {
+            std::cerr << "Unknown event type: " << ev.type << "\n";
+            return false;
+        }
+        if (ev.type == "capacity" && !IsDataRate(ev.bw))
+        {
+            std::cerr << "Capacity event at " << ev.time << "s needs a valid bandwidth, not \""
+                      << ev.bw << "\"\n";
+            return false;
+        }
+        events.push_back(ev);
+    }
+    return true;
+}
+
+bool
+LoadRoutes(const std::string& file, std::vector<RouteSpec>& routes)
+{
+    std::ifstream rfs(file);
+    if (!rfs.is_open())
+        return false;
+
+    try
+    {
+        json rj;
+        rfs >> rj;
+        if (!rj.contains("routes"))
+            return true;
+        for (auto& entry : rj["routes"])
+        {
+            RouteSpec r;
+            r.src = entry["src"];
+            r.dst = entry["dst"];
+            r.nextHop = entry["next_hop"];
+            if (entry.contains("path"))
+                r.path = entry["path"].get<std::vector<uint32_t>>();
+            r.demand = entry.value("demand", 0.0);
+            routes.push_back(std::move(r));
+        }
+    }
+    catch (...)
+    {
+        NS_LOG_WARN("Failed to parse routing.json");
+        return false;
+    }
+    return true;
+}
+
+uint32_t
+LinkNetwork(uint32_t k, size_t nLinks, uint32_t& prefixLen)
+{
+    NS_ABORT_MSG_IF(k > kMaxLinks, "Link " << k << " is outside 10.0.0.0/8");
+    prefixLen = nLinks < 65536 ? 24 : 30;
+    return (10u << 24) | (k << (32 - prefixLen));
+}
+
+std::vector<std::string>
+FirstNodeAddresses(uint32_t nNodes, const std::vector<LinkSpec>& links)
+{
+    auto dotted = [](uint32_t a) {
+        std::ostringstream oss;
+        oss << (a >> 24) << "." << ((a >> 16) & 255) << "." << ((a >> 8) & 255) << "." << (a & 255);
+        return oss.str();
+    };
+    std::vector<std::string> first(nNodes);
+    uint32_t subnetIndex = 1;
+    for (auto& lk : links)
+    {
+        uint32_t prefixLen;
+        uint32_t net = LinkNetwork(subnetIndex, links.size(), prefixLen);
+        if (first[lk.src].empty())
+            first[lk.src] = dotted(net + 1);
+        if (first[lk.dst].empty())
+            first[lk.dst] = dotted(net + 2);
+        subnetIndex++;
+    }
+    return first;
+}
@@ -0,0 +1,74 @@
+#ifndef TOPOLOGY_SPEC_H
+#define TOPOLOGY_SPEC_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One topology.json link; devices are full duplex, so it carries traffic in
+// both directions.
+struct LinkSpec
+{
+    uint32_t src;
+    uint32_t dst;
+    std::string bw;
+    std::string delay;
+    std::string queueType; // DropTail, RED, CoDel, FqCoDel; empty = DropTail
+    std::string queueSize; // "100p" or "64KB"; empty = bandwidth-delay product
+};
+
+// One entry of topology.json "events": a link going down or up, or changing
+// capacity, at `time` seconds.
+struct LinkEvent
+{
+    double time;
+    std::string type; // link_down, link_up or capacity
+    uint32_t link;    // index into the links array
+    std::string bw;   // new rate for capacity events
+};
+
+// One routing.json route as produced by ml/infer_routes.py.
+struct RouteSpec
+{
+    uint32_t src;
+    uint32_t dst;
+    uint32_t nextHop;
+    std::vector<uint32_t> path; // src ... dst, empty if absent
+    double demand = 0.0;        // Mbps, 0 if absent
+};
+
+// DropTail, RED, CoDel or FqCoDel.
+bool IsQueueType(const std::string& type);
+// A rate ns-3 parses, such as "10Mbps" or "1Gb/s".
+bool IsDataRate(const std::string& rate);
+// A non-negative time ns-3 parses, such as "1ms" or "2.5us".
+bool IsDelay(const std::string& delay);
+
+// Load topology.json. Prints an error and returns false if it cannot be read,
+// has more than kMaxLinks links, a link names an unknown queue type, or an
+// event lacks its time, type or link, names a link that does not exist or
+// sets no valid capacity.
+bool LoadTopology(const std::string& file,
+                  uint32_t& nNodes,
+                  std::vector<LinkSpec>& links,
+                  std::vector<LinkEvent>& events);
+
+// Load routing.json. Returns false (leaving `routes` as parsed so far) if the
+// file is missing or malformed.
+bool LoadRoutes(const std::string& file, std::vector<RouteSpec>& routes);
+
+// Links ns3_sim's addressing plan can number: the /30s of 10.0.0.0/8 after
+// the first.
+const size_t kMaxLinks = (size_t(1) << 22) - 1;
+
+// Network address (host byte order) and prefix length of link k (from 1)
+// under ns3_sim's addressing plan: 10.k/256.k%256.0/24 while there are at
+// most 65535 links, else the k-th /30 of 10.0.0.0/8, room for 4M links. The
+// src end is network + 1 and the dst end network + 2.
+uint32_t LinkNetwork(uint32_t k, size_t nLinks, uint32_t& prefixLen);
+
+// First address of every node under ns3_sim's addressing plan. Nodes without
+// links get an empty string.
+std::vector<std::string> FirstNodeAddresses(uint32_t nNodes, const std::vector<LinkSpec>& links);
+
+#endif // TOPOLOGY_SPEC_H